@@ -0,0 +1,183 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+#define ITERATIONS 1000000
+#define CHAIN_DEPTH 32
+#define RANDOM_SIZE 4096
+
+static uint8_t randomBits[RANDOM_SIZE];
+static volatile uint32_t sink;
+
+static void print_result(const char *name, uint64_t ticks, uint64_t branches)
+{
+    double secs = (double)ticks / (double)sys_time_get_timebase_frequency();
+    printf("%-30s %10.2f M branches/s  (%.2f ns per branch)\n", name,
+           (double)branches / secs / 1000000.0, secs * 1e9 / (double)branches);
+}
+
+/*
+ * Indirect calls through a function pointer table (bctrl + blr), the target
+ * changes every call
+ */
+typedef uint32_t (*handler_fn)(uint32_t);
+
+static __attribute__((noinline)) uint32_t handler0(uint32_t x) { return x + 1; }
+static __attribute__((noinline)) uint32_t handler1(uint32_t x) { return x ^ 0x55; }
+static __attribute__((noinline)) uint32_t handler2(uint32_t x) { return x << 1; }
+static __attribute__((noinline)) uint32_t handler3(uint32_t x) { return x - 3; }
+static __attribute__((noinline)) uint32_t handler4(uint32_t x) { return x | 0x100; }
+static __attribute__((noinline)) uint32_t handler5(uint32_t x) { return x >> 1; }
+static __attribute__((noinline)) uint32_t handler6(uint32_t x) { return x * 3; }
+static __attribute__((noinline)) uint32_t handler7(uint32_t x) { return ~x; }
+
+static handler_fn handlers[8] = {
+    handler0, handler1, handler2, handler3, handler4, handler5, handler6, handler7,
+};
+
+static uint64_t bench_indirect_call(void)
+{
+    uint32_t x = 0;
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < ITERATIONS; ++i)
+        x = handlers[randomBits[i & (RANDOM_SIZE - 1)] & 7](x);
+    uint64_t ticks = __mftb() - start;
+    sink = x;
+    return ticks;
+}
+
+/*
+ * Deep call chains, CHAIN_DEPTH nested bl/blr pairs per iteration. The empty
+ * asm after the call keeps gcc from turning the recursion into a loop
+ */
+static __attribute__((noinline)) uint32_t chain(uint32_t depth, uint32_t x)
+{
+    if (depth == 0)
+        return x;
+    uint32_t r = chain(depth - 1, x + depth);
+    __asm__ volatile ("" : "+r"(r));
+    return r + 1;
+}
+
+static uint64_t bench_call_chain(void)
+{
+    uint32_t x = 0;
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < ITERATIONS / CHAIN_DEPTH; ++i)
+        x += chain(CHAIN_DEPTH, i);
+    uint64_t ticks = __mftb() - start;
+    sink = x;
+    return ticks;
+}
+
+/*
+ * Computed jumps through CTR (mtctr/bctr), using labels as values so the
+ * dispatch stays a single bctr like an interpreter loop
+ */
+static uint64_t bench_computed_jump(void)
+{
+    static void *targets[8] = { &&op0, &&op1, &&op2, &&op3, &&op4, &&op5, &&op6, &&op7 };
+    uint32_t x = 0;
+    uint32_t i = 0;
+
+    uint64_t start = __mftb();
+next:
+    if (i == ITERATIONS)
+        goto done;
+    goto *targets[randomBits[i++ & (RANDOM_SIZE - 1)] & 7];
+op0: x += 1; goto next;
+op1: x ^= 0x55; goto next;
+op2: x <<= 1; goto next;
+op3: x -= 3; goto next;
+op4: x |= 0x100; goto next;
+op5: x >>= 1; goto next;
+op6: x *= 3; goto next;
+op7: x = ~x; goto next;
+done:;
+    uint64_t ticks = __mftb() - start;
+    sink = x;
+    return ticks;
+}
+
+/*
+ * Conditional branches on random data against the same loop on a fixed
+ * pattern, the difference is the misprediction cost
+ */
+static uint64_t bench_conditional(int predictable)
+{
+    uint32_t x = 0;
+    uint32_t mask = predictable ? 0 : 1;
+    __asm__ volatile ("" : "+r"(mask));     // or a constant mask folds the branch away
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+        if (randomBits[i & (RANDOM_SIZE - 1)] & mask)
+            x += 3;
+        else
+            x ^= i;
+        __asm__ volatile ("" : "+r"(x));  // keep gcc from making this branchless
+    }
+    uint64_t ticks = __mftb() - start;
+    sink = x;
+    return ticks;
+}
+
+/*
+ * bdnz counted loop and bdnzlr conditional return
+ */
+static uint64_t bench_bdnz(void)
+{
+    uint64_t start = __mftb();
+    __asm__ volatile (
+        "mtctr %0\n"
+        "1: bdnz 1b\n"
+        :: "r"((uint64_t)ITERATIONS) : "ctr");
+    return __mftb() - start;
+}
+
+static uint64_t bench_conditional_return(void)
+{
+    uint64_t start = __mftb();
+    __asm__ volatile (
+        "   mflr 0\n"
+        "   mtctr %0\n"
+        "1: bl 2f\n"
+        "   b 3f\n"
+        "2: bdnzlr\n"      // return while CTR != 0
+        "   blr\n"
+        "3: mfctr 11\n"
+        "   cmpdi 11,0\n"
+        "   bne 1b\n"
+        "   mtlr 0\n"
+        :: "r"((uint64_t)ITERATIONS) : "r0", "r11", "ctr", "lr", "cr0");
+    return __mftb() - start;
+}
+
+int main(void)
+{
+    uint32_t rng = 0x12345678;
+    for (int i = 0; i < RANDOM_SIZE; ++i) {
+        rng = rng * 1664525u + 1013904223u;
+        randomBits[i] = rng >> 24;
+    }
+
+    printf("branch benchmark, %d iterations per kernel\n", ITERATIONS);
+
+    // branch counts per iteration: bctrl + blr, bl + blr per level,
+    // bctr + b back, one bc, one bdnz, bl + bdnzlr + b + bc
+    print_result("indirect call table", bench_indirect_call(), (uint64_t)ITERATIONS * 2);
+    print_result("deep call chain", bench_call_chain(),
+                 (uint64_t)(ITERATIONS / CHAIN_DEPTH) * (CHAIN_DEPTH + 1) * 2);
+    print_result("computed jump (bctr)", bench_computed_jump(), (uint64_t)ITERATIONS * 2);
+    print_result("conditional, predictable", bench_conditional(1), ITERATIONS);
+    print_result("conditional, random", bench_conditional(0), ITERATIONS);
+    print_result("bdnz loop", bench_bdnz(), ITERATIONS);
+    print_result("bl + bdnzlr return", bench_conditional_return(), (uint64_t)ITERATIONS * 4);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+#define LOOPS 200000
+
+typedef union {
+    uint64_t u;
+    double d;
+} dbl_bits;
+
+static double baselineNs;
+
+static double tb_to_ns(uint64_t ticks)
+{
+    return (double)ticks * 1000000000.0 / (double)sys_time_get_timebase_frequency() / LOOPS;
+}
+
+static void print_row(const char *name, uint64_t ticks, double overheadNs)
+{
+    double ns = tb_to_ns(ticks) - overheadNs;
+    printf("%-34s %8.2f ns  %6.2fx\n", name, ns, baselineNs > 0.0 ? ns / baselineNs : 1.0);
+}
+
+// Loops a single asm statement with three fp inputs and one fp output
+#define TIME_FP(insn, ticks) do { \
+    uint64_t start = __mftb(); \
+    for (uint32_t i = 0; i < LOOPS; ++i) \
+        __asm__ volatile (insn : "=&f"(r) : "f"(a), "f"(b), "f"(zero)); \
+    ticks = __mftb() - start; \
+} while (0)
+
+static void clear_fpscr(void)
+{
+    double zero = 0.0;
+    __asm__ volatile ("mtfsf 255,%0" :: "f"(zero));
+}
+
+/*
+ * Each exception producing op is timed twice:
+ *  - sticky: FPSCR is only cleared once, after the first iteration the
+ *    exception bits are already set so only the result has to be computed
+ *  - fresh: FPSCR is cleared before every op so FX/VX/the exception bit go
+ *    0->1 each time, the cost of the mtfsf itself is subtracted
+ */
+typedef struct {
+    const char *name;
+    double a, b;
+} fp_case;
+
+int main(void)
+{
+    dbl_bits snan = { 0x7FF4000000000000ULL };
+    dbl_bits inf = { 0x7FF0000000000000ULL };
+    dbl_bits huge = { 0x7FEFFFFFFFFFFFFFULL };
+    dbl_bits tiny = { 0x0010000000000000ULL };
+    double zero = 0.0;
+    double a, b, r;
+    uint64_t ticks;
+
+    printf("FPSCR exception path benchmark, %d iterations per case\n", LOOPS);
+    printf("%-34s %11s  %s\n", "", "per op", "vs clean");
+
+    // mtfsf overhead, subtracted from the fresh rows
+    clear_fpscr();
+    a = 1.0;
+    b = 2.0;
+    TIME_FP("mtfsf 255,%3", ticks);
+    uint64_t mtfsfTicks = ticks;
+    double mtfsfNs = tb_to_ns(mtfsfTicks);
+
+    // clean baseline, exact result so not even XX gets set
+    clear_fpscr();
+    TIME_FP("fadd %0,%1,%2", ticks);
+    baselineNs = tb_to_ns(ticks);
+    print_row("fadd clean", ticks, 0.0);
+
+    clear_fpscr();
+    TIME_FP("mtfsf 255,%3\n fadd %0,%1,%2", ticks);
+    print_row("fadd clean, fresh fpscr", ticks, mtfsfNs);
+
+    // fadd/fmul/fdiv with operands picked to raise one exception each
+    const fp_case cases[] = {
+        { "fadd inexact (XX)",         1.0,          1.0 / 3.0 },
+        { "fadd snan (VXSNAN)",        snan.d,       1.0 },
+        { "fadd inf-inf (VXISI)",      inf.d,        -inf.d },
+        { "fadd overflow (OX)",        huge.d,       huge.d },
+    };
+    for (int c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); ++c) {
+        char name[64];
+        a = cases[c].a;
+        b = cases[c].b;
+        clear_fpscr();
+        TIME_FP("fadd %0,%1,%2", ticks);
+        snprintf(name, sizeof(name), "%s sticky", cases[c].name);
+        print_row(name, ticks, 0.0);
+        TIME_FP("mtfsf 255,%3\n fadd %0,%1,%2", ticks);
+        snprintf(name, sizeof(name), "%s fresh", cases[c].name);
+        print_row(name, ticks, mtfsfNs);
+    }
+
+    const fp_case mulCases[] = {
+        { "fmul 0*inf (VXIMZ)",        zero,         inf.d },
+        { "fmul underflow (UX)",       tiny.d,       tiny.d },
+    };
+    for (int c = 0; c < (int)(sizeof(mulCases) / sizeof(mulCases[0])); ++c) {
+        char name[64];
+        a = mulCases[c].a;
+        b = mulCases[c].b;
+        clear_fpscr();
+        TIME_FP("fmul %0,%1,%2", ticks);
+        snprintf(name, sizeof(name), "%s sticky", mulCases[c].name);
+        print_row(name, ticks, 0.0);
+        TIME_FP("mtfsf 255,%3\n fmul %0,%1,%2", ticks);
+        snprintf(name, sizeof(name), "%s fresh", mulCases[c].name);
+        print_row(name, ticks, mtfsfNs);
+    }
+
+    a = 1.0;
+    b = zero;
+    clear_fpscr();
+    TIME_FP("fdiv %0,%1,%2", ticks);
+    print_row("fdiv 1/0 (ZX) sticky", ticks, 0.0);
+    TIME_FP("mtfsf 255,%3\n fdiv %0,%1,%2", ticks);
+    print_row("fdiv 1/0 (ZX) fresh", ticks, mtfsfNs);
+
+    // FPSCR access itself
+    printf("\n");
+    a = 1.0;
+    b = 2.0;
+    clear_fpscr();
+    print_row("mtfsf 255", mtfsfTicks, 0.0);
+    TIME_FP("mffs %0", ticks);
+    print_row("mffs", ticks, 0.0);
+    TIME_FP("mffs %0\n mtfsf 255,%0", ticks);
+    print_row("mffs/mtfsf round trip", ticks, 0.0);
+    TIME_FP("mtfsb1 3\n mtfsb0 3", ticks);
+    print_row("mtfsb1/mtfsb0 pair", ticks, 0.0);
+
+    // rounding mode switches around an inexact add, the way titles toggle
+    // truncation for float->int conversion
+    a = 1.0;
+    b = 1.0 / 3.0;
+    clear_fpscr();
+    TIME_FP("fadd %0,%1,%2\n fadd %0,%0,%2", ticks);
+    print_row("2x fadd, no rounding switch", ticks, 0.0);
+    TIME_FP("mtfsfi 7,1\n fadd %0,%1,%2\n mtfsfi 7,0\n fadd %0,%0,%2", ticks);
+    print_row("2x fadd, mtfsfi RN switch", ticks, 0.0);
+    TIME_FP("mtfsb1 31\n fadd %0,%1,%2\n mtfsb0 31\n fadd %0,%0,%2", ticks);
+    print_row("2x fadd, mtfsb RN switch", ticks, 0.0);
+    TIME_FP("mtfsfi 7,1\n fctiw %0,%1\n mtfsfi 7,0", ticks);
+    print_row("truncating fctiw via RN switch", ticks, 0.0);
+    TIME_FP("fctiwz %0,%1", ticks);
+    print_row("fctiwz", ticks, 0.0);
+
+    (void)r;
+    clear_fpscr();
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <altivec.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+// How many times each component runs per frame, 0 disables it. Can be
+// overridden at build time to change the mix, e.g. -DMIX_VMX=4
+#ifndef MIX_INT
+#define MIX_INT 1
+#endif
+#ifndef MIX_FP
+#define MIX_FP 1
+#endif
+#ifndef MIX_VMX
+#define MIX_VMX 1
+#endif
+#ifndef MIX_WALK
+#define MIX_WALK 1
+#endif
+
+#ifndef FRAMES
+#define FRAMES 500
+#endif
+
+#define NUM_ENTITIES 1024
+#define NUM_BODIES 2048
+#define NUM_VERTS 4096
+#define NUM_BONES 32
+#define NUM_NODES 8192
+
+typedef vector float vf32;
+
+/*
+ * Branchy integer section: an AI style state machine per entity, with
+ * data dependent branches and a switch the compiler turns into a jump table
+ */
+typedef struct {
+    int32_t state;
+    int32_t timer;
+    int32_t health;
+    int32_t target;
+    uint32_t rng;
+} entity_t;
+
+static entity_t *entities;
+
+static uint32_t run_int(void)
+{
+    uint32_t acc = 0;
+
+    for (int i = 0; i < NUM_ENTITIES; ++i) {
+        entity_t *e = &entities[i];
+        e->rng = e->rng * 1664525u + 1013904223u;
+        uint32_t roll = e->rng >> 24;
+
+        switch (e->state) {
+        case 0:  // idle
+            if (roll < 32)
+                e->state = 1;
+            break;
+        case 1:  // patrol
+            e->timer++;
+            if (e->timer > 20 || roll < 8) {
+                e->timer = 0;
+                e->state = (roll & 1) ? 2 : 0;
+            }
+            break;
+        case 2:  // chase
+            e->target = (e->target + (int32_t)(roll & 7) - 3) & (NUM_ENTITIES - 1);
+            if (entities[e->target].health <= 0)
+                e->state = 0;
+            else if (roll > 200)
+                e->state = 3;
+            break;
+        case 3:  // attack
+            entities[e->target].health -= (int32_t)(roll & 15);
+            e->state = (roll & 3) ? 2 : 4;
+            break;
+        default:  // respawn
+            e->health = 100;
+            e->state = 0;
+            break;
+        }
+        if (e->health <= 0 && e->state != 4)
+            e->state = 4;
+        acc += e->state + (e->health & 0xFF);
+    }
+    return acc;
+}
+
+/*
+ * FP physics: semi implicit euler with gravity, drag and a bouncing floor,
+ * single precision like most game code
+ */
+typedef struct {
+    float px, py, pz;
+    float vx, vy, vz;
+    float invMass, restitution;
+} body_t;
+
+static body_t *bodies;
+
+static uint32_t run_fp(void)
+{
+    const float dt = 1.0f / 60.0f;
+    const float gravity = -9.8f;
+    const float drag = 0.995f;
+    float sum = 0.0f;
+
+    for (int i = 0; i < NUM_BODIES; ++i) {
+        body_t *b = &bodies[i];
+        b->vy += gravity * dt;
+        b->vx *= drag;
+        b->vy *= drag;
+        b->vz *= drag;
+        b->px += b->vx * dt;
+        b->py += b->vy * dt;
+        b->pz += b->vz * dt;
+        if (b->py < 0.0f) {
+            b->py = -b->py;
+            b->vy = -b->vy * b->restitution;
+        }
+        sum += b->py * b->invMass;
+    }
+    return (uint32_t)(int32_t)sum;
+}
+
+/*
+ * VMX skinning: every vertex blends two bone matrices by weight, matrices
+ * are stored as 4 columns
+ */
+typedef struct {
+    vf32 pos;
+    vf32 weights;      // x = weight of bone 0, y = weight of bone 1
+    uint32_t bone[4];  // only bone[0] and bone[1] are used
+} vertex_t;
+
+static vertex_t *verts;
+static vf32 *skinned;
+static vf32 *bones;
+
+static inline vf32 transform(const vf32 *m, vf32 v)
+{
+    const vf32 zero = (vf32){ -0.0f, -0.0f, -0.0f, -0.0f };
+    vf32 r = vec_madd(m[0], vec_splat(v, 0), zero);
+    r = vec_madd(m[1], vec_splat(v, 1), r);
+    r = vec_madd(m[2], vec_splat(v, 2), r);
+    return vec_madd(m[3], vec_splat(v, 3), r);
+}
+
+static uint32_t run_vmx(void)
+{
+    const vf32 zero = (vf32){ -0.0f, -0.0f, -0.0f, -0.0f };
+    vf32 acc = zero;
+
+    for (int i = 0; i < NUM_VERTS; ++i) {
+        const vertex_t *v = &verts[i];
+        vf32 a = transform(&bones[v->bone[0] * 4], v->pos);
+        vf32 b = transform(&bones[v->bone[1] * 4], v->pos);
+        vf32 r = vec_madd(a, vec_splat(v->weights, 0), zero);
+        r = vec_madd(b, vec_splat(v->weights, 1), r);
+        skinned[i] = r;
+        acc = vec_add(acc, r);
+    }
+
+    float out[4] __attribute__((aligned(16)));
+    vec_st(acc, 0, out);
+    return (uint32_t)(int32_t)(out[0] + out[1] + out[2]);
+}
+
+/*
+ * Load/store heavy structure walk: scene graph nodes in a shuffled order,
+ * pointer chasing through the sibling chain and updating flags
+ */
+typedef struct node {
+    struct node *next;
+    uint32_t flags;
+    uint16_t type;
+    uint16_t depth;
+    uint32_t data[4];
+} node_t;
+
+static node_t *nodes;
+
+static uint32_t run_walk(void)
+{
+    uint32_t acc = 0;
+
+    for (node_t *n = &nodes[0]; n != NULL; n = n->next) {
+        if (n->flags & 1) {
+            n->data[n->type & 3] += n->depth;
+            n->flags ^= 2;
+        }
+        n->flags ^= (n->data[0] & 1);
+        acc += n->data[1] + n->flags;
+    }
+    return acc;
+}
+
+static void init(void)
+{
+    uint32_t rng = 12345;
+
+    entities = memalign(128, sizeof(entity_t) * NUM_ENTITIES);
+    for (int i = 0; i < NUM_ENTITIES; ++i) {
+        entities[i].state = i & 3;
+        entities[i].timer = 0;
+        entities[i].health = 100;
+        entities[i].target = (i * 7) & (NUM_ENTITIES - 1);
+        entities[i].rng = i * 2654435761u;
+    }
+
+    bodies = memalign(128, sizeof(body_t) * NUM_BODIES);
+    for (int i = 0; i < NUM_BODIES; ++i) {
+        bodies[i].px = (float)(i & 63);
+        bodies[i].py = (float)(i & 15) + 1.0f;
+        bodies[i].pz = (float)(i >> 6);
+        bodies[i].vx = 0.5f;
+        bodies[i].vy = 0.0f;
+        bodies[i].vz = -0.25f;
+        bodies[i].invMass = 1.0f / (float)((i & 7) + 1);
+        bodies[i].restitution = 0.8f;
+    }
+
+    bones = memalign(128, sizeof(vf32) * 4 * NUM_BONES);
+    for (int i = 0; i < NUM_BONES; ++i) {
+        float s = 1.0f + (float)i * 0.01f;
+        bones[i * 4 + 0] = (vf32){ s, 0.0f, 0.0f, 0.0f };
+        bones[i * 4 + 1] = (vf32){ 0.0f, s, 0.0f, 0.0f };
+        bones[i * 4 + 2] = (vf32){ 0.0f, 0.0f, s, 0.0f };
+        bones[i * 4 + 3] = (vf32){ (float)i, 0.0f, (float)-i, 1.0f };
+    }
+
+    verts = memalign(128, sizeof(vertex_t) * NUM_VERTS);
+    skinned = memalign(128, sizeof(vf32) * NUM_VERTS);
+    for (int i = 0; i < NUM_VERTS; ++i) {
+        float w = (float)(i & 15) / 15.0f;
+        verts[i].pos = (vf32){ (float)(i & 31), (float)((i >> 5) & 31), (float)(i >> 10), 1.0f };
+        verts[i].weights = (vf32){ w, 1.0f - w, 0.0f, 0.0f };
+        verts[i].bone[0] = i % NUM_BONES;
+        verts[i].bone[1] = (i * 5 + 3) % NUM_BONES;
+        verts[i].bone[2] = 0;
+        verts[i].bone[3] = 0;
+    }
+
+    // link the nodes in a random order so the walk can't be prefetched
+    nodes = memalign(128, sizeof(node_t) * NUM_NODES);
+    uint32_t *order = malloc(sizeof(uint32_t) * NUM_NODES);
+    for (int i = 0; i < NUM_NODES; ++i)
+        order[i] = i;
+    for (int i = NUM_NODES - 1; i > 1; --i) {
+        rng = rng * 1664525u + 1013904223u;
+        int j = 1 + (rng >> 8) % i;
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (int i = 0; i < NUM_NODES; ++i) {
+        node_t *n = &nodes[order[i]];
+        n->next = (i + 1 < NUM_NODES) ? &nodes[order[i + 1]] : NULL;
+        n->flags = i & 3;
+        n->type = i & 0xFFFF;
+        n->depth = i & 15;
+        memset(n->data, 0, sizeof(n->data));
+        n->data[0] = i;
+    }
+    free(order);
+}
+
+int main(void)
+{
+    uint64_t ticks[4] = { 0, 0, 0, 0 };
+    uint32_t checksum = 0;
+
+    init();
+
+    printf("synthetic game loop, %d frames, mix int %d fp %d vmx %d walk %d\n",
+           FRAMES, MIX_INT, MIX_FP, MIX_VMX, MIX_WALK);
+
+    uint64_t start = __mftb();
+    for (int f = 0; f < FRAMES; ++f) {
+        uint64_t t0 = __mftb();
+        for (int i = 0; i < MIX_INT; ++i)
+            checksum += run_int();
+        uint64_t t1 = __mftb();
+        for (int i = 0; i < MIX_FP; ++i)
+            checksum += run_fp();
+        uint64_t t2 = __mftb();
+        for (int i = 0; i < MIX_VMX; ++i)
+            checksum += run_vmx();
+        uint64_t t3 = __mftb();
+        for (int i = 0; i < MIX_WALK; ++i)
+            checksum += run_walk();
+        uint64_t t4 = __mftb();
+
+        ticks[0] += t1 - t0;
+        ticks[1] += t2 - t1;
+        ticks[2] += t3 - t2;
+        ticks[3] += t4 - t3;
+        checksum = (checksum << 1) | (checksum >> 31);
+    }
+    uint64_t total = __mftb() - start;
+
+    double freq = (double)sys_time_get_timebase_frequency();
+    double secs = (double)total / freq;
+    printf("%.2f iterations/s (%.3f ms per frame)\n", FRAMES / secs, secs * 1000.0 / FRAMES);
+
+    static const char *names[4] = { "integer", "fp physics", "vmx skinning", "structure walk" };
+    for (int i = 0; i < 4; ++i) {
+        printf("  %-16s %8.3f ms per frame  %5.1f%%\n", names[i],
+               (double)ticks[i] * 1000.0 / freq / FRAMES, (double)ticks[i] * 100.0 / (double)total);
+    }
+
+    // same build and mix always gives the same checksum, a different one
+    // means the emulator computed something wrong along the way
+    printf("checksum: 0x%08x\n", checksum);
+
+    return 0;
+}
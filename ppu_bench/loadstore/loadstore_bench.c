@@ -0,0 +1,223 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+// Bytes moved per kernel and working set, passes are scaled to match
+#define TOTAL_BYTES (64 * 1024 * 1024)
+#define MAX_SET (8 * 1024 * 1024)
+#define PAGE_SIZE 4096
+#define PAGE_CROSS_ACCESSES 1000000
+
+static const uint32_t workingSets[] = {
+    16 * 1024,        // L1 (32KB)
+    64 * 1024,
+    256 * 1024,       // L2 (512KB)
+    1024 * 1024,
+    MAX_SET,          // main memory
+};
+#define NUM_SETS (sizeof(workingSets) / sizeof(workingSets[0]))
+
+static uint8_t *buf;
+static volatile uint64_t sink;
+
+/*
+ * Kernels walk [p, end) with the given misalignment, 4 accesses per loop so
+ * the loop overhead stays small. Every access is a single instruction from
+ * inline asm, so the compiler can't split misaligned ones into byte loads
+ */
+#define LOAD_D(insn, size) \
+    __asm__ volatile (insn " %0,0(%4)\n" insn " %1,%5(%4)\n" \
+                      insn " %2,%6(%4)\n" insn " %3,%7(%4)\n" \
+                      : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) \
+                      : "b"(p), "i"(size), "i"(size * 2), "i"(size * 3)); \
+    acc ^= a ^ b ^ c ^ d;
+
+#define LOAD_X(insn, size) \
+    __asm__ volatile (insn " %0,0,%4\n" insn " %1,%5,%4\n" \
+                      insn " %2,%6,%4\n" insn " %3,%7,%4\n" \
+                      : "=&r"(a), "=&r"(b), "=&r"(c), "=&r"(d) \
+                      : "b"(p), "b"(o1), "b"(o2), "b"(o3)); \
+    acc ^= a ^ b ^ c ^ d;
+
+#define STORE_D(insn, size) \
+    __asm__ volatile (insn " %1,0(%0)\n" insn " %1,%2(%0)\n" \
+                      insn " %1,%3(%0)\n" insn " %1,%4(%0)\n" \
+                      :: "b"(p), "r"(v), "i"(size), "i"(size * 2), "i"(size * 3) : "memory");
+
+#define STORE_X(insn, size) \
+    __asm__ volatile (insn " %1,0,%0\n" insn " %1,%2,%0\n" \
+                      insn " %1,%3,%0\n" insn " %1,%4,%0\n" \
+                      :: "b"(p), "r"(v), "b"(o1), "b"(o2), "b"(o3) : "memory");
+
+#define KERNEL(name, access, size) \
+static void name(uint8_t *p, uint8_t *end) \
+{ \
+    uint64_t a, b, c, d, acc = 0, v = 0x0123456789ABCDEFULL; \
+    uint64_t o1 = size, o2 = size * 2, o3 = size * 3; \
+    (void)a; (void)b; (void)c; (void)d; (void)v; (void)o1; (void)o2; (void)o3; \
+    for (; p < end; p += size * 4) { \
+        access \
+    } \
+    sink = acc; \
+}
+
+KERNEL(k_lwz, LOAD_D("lwz", 4), 4)
+KERNEL(k_ld, LOAD_D("ld", 8), 8)
+KERNEL(k_lhbrx, LOAD_X("lhbrx", 2), 2)
+KERNEL(k_lwbrx, LOAD_X("lwbrx", 4), 4)
+KERNEL(k_stw, STORE_D("stw", 4), 4)
+KERNEL(k_std, STORE_D("std", 8), 8)
+KERNEL(k_sthbrx, STORE_X("sthbrx", 2), 2)
+KERNEL(k_stwbrx, STORE_X("stwbrx", 4), 4)
+
+/*
+ * lmw/stmw move 8 words (r24-r31) per instruction, the copy kernel reads
+ * from the first half of the buffer and writes the second half
+ */
+static void k_lmw(uint8_t *p, uint8_t *end)
+{
+    for (; p < end; p += 32)
+        __asm__ volatile ("lmw 24,0(%0)" :: "b"(p) : "r24", "r25", "r26", "r27", "r28", "r29", "r30", "r31");
+}
+
+static void k_stmw(uint8_t *p, uint8_t *end)
+{
+    for (; p < end; p += 32)
+        __asm__ volatile ("stmw 24,0(%0)" :: "b"(p) : "memory");
+}
+
+static void k_lmw_stmw_copy(uint8_t *p, uint8_t *end)
+{
+    uint32_t half = (uint32_t)(end - p) / 2;
+    uint8_t *mid = p + half;
+    for (; p < mid; p += 32)
+        __asm__ volatile ("lmw 24,0(%0)\n stmw 24,0(%1)" :: "b"(p), "b"(p + half)
+                          : "r24", "r25", "r26", "r27", "r28", "r29", "r30", "r31", "memory");
+}
+
+typedef struct {
+    const char *name;
+    void (*fn)(uint8_t *, uint8_t *);
+    uint32_t misalign;
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    { "lwz aligned",          k_lwz,           0 },
+    { "lwz misaligned +1",    k_lwz,           1 },
+    { "ld aligned",           k_ld,            0 },
+    { "ld misaligned +3",     k_ld,            3 },
+    { "stw aligned",          k_stw,           0 },
+    { "stw misaligned +1",    k_stw,           1 },
+    { "std aligned",          k_std,           0 },
+    { "std misaligned +3",    k_std,           3 },
+    { "lhbrx",                k_lhbrx,         0 },
+    { "lwbrx",                k_lwbrx,         0 },
+    { "lwbrx misaligned +1",  k_lwbrx,         1 },
+    { "sthbrx",               k_sthbrx,        0 },
+    { "stwbrx",               k_stwbrx,        0 },
+    { "stwbrx misaligned +1", k_stwbrx,        1 },
+    { "lmw (8 words)",        k_lmw,           0 },
+    { "stmw (8 words)",       k_stmw,          0 },
+    { "lmw/stmw copy",        k_lmw_stmw_copy, 0 },
+};
+#define NUM_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+/*
+ * Page crossing: one access straddling every page boundary in the buffer,
+ * reported per access since only one access per page happens
+ */
+static uint64_t page_cross(int store, uint32_t size, uint32_t set)
+{
+    uint64_t acc = 0;
+    uint32_t pages = set / PAGE_SIZE - 1;
+    uint64_t start = __mftb();
+    for (uint32_t i = 0, page = 0; i < PAGE_CROSS_ACCESSES; ++i) {
+        uint8_t *p = buf + (page + 1) * PAGE_SIZE - size / 2;
+        uint64_t v;
+        if (store) {
+            if (size == 4)
+                __asm__ volatile ("stw %1,0(%0)" :: "b"(p), "r"(i) : "memory");
+            else
+                __asm__ volatile ("std %1,0(%0)" :: "b"(p), "r"(i) : "memory");
+        }
+        else {
+            if (size == 4)
+                __asm__ volatile ("lwz %0,0(%1)" : "=r"(v) : "b"(p));
+            else
+                __asm__ volatile ("ld %0,0(%1)" : "=r"(v) : "b"(p));
+            acc += v;
+        }
+        if (++page == pages)
+            page = 0;
+    }
+    uint64_t ticks = __mftb() - start;
+    sink = acc;
+    return ticks;
+}
+
+int main(void)
+{
+    double freq = (double)sys_time_get_timebase_frequency();
+
+    // slack at the end for the misaligned kernels
+    buf = memalign(65536, MAX_SET + 128);
+    if (buf == NULL) {
+        printf("failed to allocate %d bytes\n", MAX_SET + 128);
+        return -1;
+    }
+    memset(buf, 0x5A, MAX_SET + 128);
+
+    printf("load/store bandwidth in MB/s, %d MB moved per cell\n", TOTAL_BYTES / (1024 * 1024));
+    printf("%-22s", "");
+    for (uint32_t s = 0; s < NUM_SETS; ++s)
+        printf(" %8uK", workingSets[s] / 1024);
+    printf("\n");
+
+    for (uint32_t k = 0; k < NUM_KERNELS; ++k) {
+        printf("%-22s", kernels[k].name);
+        for (uint32_t s = 0; s < NUM_SETS; ++s) {
+            uint32_t set = workingSets[s];
+            uint32_t passes = TOTAL_BYTES / set;
+            uint8_t *begin = buf + kernels[k].misalign;
+
+            uint64_t start = __mftb();
+            for (uint32_t i = 0; i < passes; ++i)
+                kernels[k].fn(begin, begin + set);
+            uint64_t ticks = __mftb() - start;
+
+            printf(" %9.1f", (double)passes * set / ((double)ticks / freq) / (1024.0 * 1024.0));
+        }
+        printf("\n");
+    }
+
+    printf("\npage crossing accesses in ns per access, %d accesses\n", PAGE_CROSS_ACCESSES);
+    static const struct { const char *name; int store; uint32_t size; } cross[] = {
+        { "lwz across page",  0, 4 },
+        { "ld across page",   0, 8 },
+        { "stw across page",  1, 4 },
+        { "std across page",  1, 8 },
+    };
+    for (uint32_t c = 0; c < sizeof(cross) / sizeof(cross[0]); ++c) {
+        printf("%-22s", cross[c].name);
+        for (uint32_t s = 0; s < NUM_SETS; ++s) {
+            if (workingSets[s] < PAGE_SIZE * 2) {
+                printf(" %9s", "-");
+                continue;
+            }
+            uint64_t ticks = page_cross(cross[c].store, cross[c].size, workingSets[s]);
+            printf(" %9.2f", (double)ticks * 1e9 / freq / PAGE_CROSS_ACCESSES);
+        }
+        printf("\n");
+    }
+
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/process.h>
+#include <sys/ppu_thread.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+#define MAX_THREADS 8
+#define OPS_PER_THREAD 200000
+
+// Layouts of the counters being hammered
+enum {
+    MODE_SHARED,        // every thread updates the same word
+    MODE_FALSE_SHARED,  // every thread has its own word, all in one 128 byte line
+    MODE_PRIVATE,       // every thread has its own line, baseline for no contention
+    MODE_COUNT
+};
+
+static const char *modeNames[MODE_COUNT] = { "shared", "false shared", "private" };
+
+// Line 0 is used for shared/false shared, lines 1..8 for private counters
+static uint64_t counters[(MAX_THREADS + 1) * 16] __attribute__((aligned(128)));
+
+typedef struct {
+    volatile void *target;
+    int wide;           // use ldarx/stdcx. instead of lwarx/stwcx.
+    uint64_t retries;
+} thread_ctx_t;
+
+static thread_ctx_t ctx[MAX_THREADS];
+static volatile int startFlag;
+
+static inline uint32_t atomic_inc32(volatile uint32_t *p)
+{
+    uint32_t tmp, fails = 0;
+    __asm__ volatile (
+        "1: lwarx %0,0,%2\n"
+        "   addi %0,%0,1\n"
+        "   stwcx. %0,0,%2\n"
+        "   beq 2f\n"
+        "   addi %1,%1,1\n"
+        "   b 1b\n"
+        "2:\n"
+        : "=&r"(tmp), "+r"(fails) : "r"(p) : "cr0", "memory");
+    return fails;
+}
+
+static inline uint32_t atomic_inc64(volatile uint64_t *p)
+{
+    uint64_t tmp;
+    uint32_t fails = 0;
+    __asm__ volatile (
+        "1: ldarx %0,0,%2\n"
+        "   addi %0,%0,1\n"
+        "   stdcx. %0,0,%2\n"
+        "   beq 2f\n"
+        "   addi %1,%1,1\n"
+        "   b 1b\n"
+        "2:\n"
+        : "=&r"(tmp), "+r"(fails) : "r"(p) : "cr0", "memory");
+    return fails;
+}
+
+static void bench_thread(uint64_t arg)
+{
+    thread_ctx_t *c = &ctx[arg];
+    uint64_t retries = 0;
+
+    while (!startFlag)
+        sys_ppu_thread_yield();
+
+    if (c->wide) {
+        for (int i = 0; i < OPS_PER_THREAD; ++i)
+            retries += atomic_inc64((volatile uint64_t *)c->target);
+    }
+    else {
+        for (int i = 0; i < OPS_PER_THREAD; ++i)
+            retries += atomic_inc32((volatile uint32_t *)c->target);
+    }
+    c->retries = retries;
+
+    sys_ppu_thread_exit(0);
+}
+
+// Returns the counter the given thread updates
+static volatile void *setup_target(int mode, int wide, int thread)
+{
+    switch (mode) {
+    case MODE_SHARED:
+        return &counters[0];
+    case MODE_FALSE_SHARED:
+        return wide ? (volatile void *)&counters[thread]
+                    : (volatile void *)((volatile uint32_t *)counters + thread);
+    default:
+        return &counters[(thread + 1) * 16];
+    }
+}
+
+static int run(int mode, int wide, int numThreads)
+{
+    sys_ppu_thread_t threads[MAX_THREADS];
+    int ret;
+
+    memset(counters, 0, sizeof(counters));
+    startFlag = 0;
+
+    for (int i = 0; i < numThreads; ++i) {
+        ctx[i].target = setup_target(mode, wide, i);
+        ctx[i].wide = wide;
+        ctx[i].retries = 0;
+        ret = sys_ppu_thread_create(&threads[i], bench_thread, i, 1000, 0x4000,
+                                    SYS_PPU_THREAD_CREATE_JOINABLE, "reservation bench");
+        if (ret != CELL_OK) {
+            printf("sys_ppu_thread_create failed: %d\n", ret);
+            return ret;
+        }
+    }
+
+    uint64_t start = __mftb();
+    startFlag = 1;
+
+    for (int i = 0; i < numThreads; ++i) {
+        uint64_t exitStatus;
+        ret = sys_ppu_thread_join(threads[i], &exitStatus);
+        if (ret != CELL_OK) {
+            printf("sys_ppu_thread_join failed: %d\n", ret);
+            return ret;
+        }
+    }
+    uint64_t ticks = __mftb() - start;
+
+    // lost updates mean a stwcx./stdcx. succeeded without holding the reservation
+    uint64_t retries = 0;
+    uint64_t counted = 0;
+    for (int i = 0; i < numThreads; ++i) {
+        retries += ctx[i].retries;
+        if (mode == MODE_SHARED && i > 0)
+            continue;
+        counted += wide ? *(volatile uint64_t *)ctx[i].target : *(volatile uint32_t *)ctx[i].target;
+    }
+    uint64_t total = (uint64_t)numThreads * OPS_PER_THREAD;
+
+    double secs = (double)ticks / (double)sys_time_get_timebase_frequency();
+    printf("%-12s %s %d threads: %10.0f ops/s, retry rate %6.3f", modeNames[mode],
+           wide ? "ldarx/stdcx." : "lwarx/stwcx.", numThreads, (double)total / secs,
+           (double)retries / (double)total);
+    if (counted != total)
+        printf("  LOST UPDATES: %llu of %llu", (unsigned long long)(total - counted), (unsigned long long)total);
+    printf("\n");
+
+    return counted == total ? 0 : 1;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("reservation contention benchmark, %d ops per thread\n", OPS_PER_THREAD);
+
+    for (int wide = 0; wide < 2; ++wide) {
+        for (int mode = 0; mode < MODE_COUNT; ++mode) {
+            for (int n = 1; n <= MAX_THREADS; ++n) {
+                int ret = run(mode, wide, n);
+                if (ret < 0)
+                    return ret;
+                failed += ret;
+            }
+        }
+    }
+
+    if (failed)
+        printf("%d runs lost updates!\n", failed);
+    else
+        printf("done, no lost updates\n");
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+#define CALLS 20000
+#define BODY_INSNS 32
+
+#define INSN_LI_R3(imm)   (0x38600000u | ((imm) & 0xFFFF))  // li r3,imm
+#define INSN_ADDI_R3_1    0x38630001u                       // addi r3,r3,1
+#define INSN_BLR          0x4E800020u                       // blr
+
+/*
+ * The patched function, kept in .data so it can be written:
+ *     li r3,imm
+ *     addi r3,r3,1   (BODY_INSNS times)
+ *     blr
+ * 34 instructions span two 128 byte lines, write_code flushes both and the
+ * patched li is in the first. The array is padded so no other data shares
+ * those lines
+ */
+static uint32_t code[128] __attribute__((aligned(128), section(".data")));
+
+enum {
+    SYNC_NONE,     // just store the new word
+    SYNC_FULL,     // dcbst, sync, icbi, isync
+    SYNC_ONLY,     // full sequence but the code isn't changed
+    SYNC_COUNT
+};
+
+static const char *syncNames[SYNC_COUNT] = {
+    "store only",
+    "dcbst/sync/icbi/isync",
+    "sync sequence, no change",
+};
+
+static inline uint32_t call_code(void)
+{
+    uint64_t ret;
+    __asm__ volatile (
+        "mtctr %1\n"
+        "bctrl\n"
+        "mr %0,3\n"
+        : "=r"(ret) : "r"(code) : "r3", "ctr", "lr", "memory");
+    return (uint32_t)ret;
+}
+
+static inline void sync_code(void *addr)
+{
+    __asm__ volatile (
+        "dcbst 0,%0\n"
+        "sync\n"
+        "icbi 0,%0\n"
+        "isync\n"
+        :: "r"(addr) : "memory");
+}
+
+static void write_code(void)
+{
+    code[0] = INSN_LI_R3(0);
+    for (int i = 1; i <= BODY_INSNS; ++i)
+        code[i] = INSN_ADDI_R3_1;
+    code[BODY_INSNS + 1] = INSN_BLR;
+    for (int i = 0; i < BODY_INSNS + 2; i += 32)
+        sync_code(&code[i]);
+}
+
+/*
+ * Patches the li every patchEvery calls and calls the function each time,
+ * returns the number of calls that came back with a stale immediate
+ */
+static uint32_t run(int mode, int patchEvery, uint64_t *ticks)
+{
+    uint32_t imm = 0;
+    uint32_t stale = 0;
+
+    write_code();
+
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < CALLS; ++i) {
+        if (i % patchEvery == 0) {
+            if (mode != SYNC_ONLY) {
+                imm = (imm + 1) & 0x7FFF;
+                code[0] = INSN_LI_R3(imm);
+            }
+            if (mode != SYNC_NONE)
+                sync_code(&code[0]);
+        }
+        if (call_code() != imm + BODY_INSNS)
+            stale++;
+    }
+    *ticks = __mftb() - start;
+
+    return stale;
+}
+
+int main(void)
+{
+    static const int patchEvery[] = { 1, 4, 16, 64, 256, CALLS };
+    double freq = (double)sys_time_get_timebase_frequency();
+
+    printf("self modifying code benchmark, %d calls per run, %d insn function\n", CALLS, BODY_INSNS + 2);
+    printf("%-26s %12s %12s %10s\n", "", "patch every", "ns per call", "stale");
+
+    // reference without any patching at all
+    uint64_t ticks;
+    write_code();
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < CALLS; ++i)
+        call_code();
+    ticks = __mftb() - start;
+    printf("%-26s %12s %12.1f %10s\n", "no patching", "-", (double)ticks * 1e9 / freq / CALLS, "-");
+
+    // stale results are allowed without the sync sequence, but never with it
+    uint32_t staleSynced = 0;
+    for (int mode = 0; mode < SYNC_COUNT; ++mode) {
+        for (int p = 0; p < (int)(sizeof(patchEvery) / sizeof(patchEvery[0])); ++p) {
+            uint32_t stale = run(mode, patchEvery[p], &ticks);
+            printf("%-26s %12d %12.1f %10u\n", syncNames[mode], patchEvery[p],
+                   (double)ticks * 1e9 / freq / CALLS, stale);
+            if (mode != SYNC_NONE)
+                staleSynced += stale;
+        }
+    }
+
+    if (staleSynced)
+        printf("FAIL: %u stale results after dcbst/sync/icbi/isync\n", staleSynced);
+    else
+        printf("done, no stale code after icbi\n");
+
+    return 0;
+}
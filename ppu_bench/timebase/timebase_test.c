@@ -0,0 +1,216 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/ppu_thread.h>
+#include <sys/sys_time.h>
+#include <sys/timer.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+#define NUM_THREADS 4
+#define READS_PER_THREAD 1000000
+#define OVERHEAD_READS 1000000
+
+/*
+ * mftb/mftbu are coded directly, same as in ppu_test/cell-ppu.s, since some
+ * binutils versions encode them as mfspr
+ */
+static inline uint64_t read_tb(void)
+{
+    uint64_t tb;
+    __asm__ volatile (".int 0x7C6C42E6\n mr %0,3" : "=r"(tb) :: "r3");  // mftb %r3
+    return tb;
+}
+
+static inline uint32_t read_tbu(void)
+{
+    uint64_t tbu;
+    __asm__ volatile (".int 0x7C6D42E6\n mr %0,3" : "=r"(tbu) :: "r3");  // mftbu %r3
+    return (uint32_t)tbu;
+}
+
+static int failed = 0;
+
+/*
+ * Tick rate: mftb delta against sys_time_get_system_time across a sleep, the
+ * two should agree with sys_time_get_timebase_frequency
+ */
+static void test_rate(void)
+{
+    static const usecond_t intervals[] = { 10000, 100000, 1000000 };
+    uint64_t freq = sys_time_get_timebase_frequency();
+
+    printf("timebase frequency reported: %llu Hz\n", (unsigned long long)freq);
+
+    for (int i = 0; i < (int)(sizeof(intervals) / sizeof(intervals[0])); ++i) {
+        usecond_t t0 = sys_time_get_system_time();
+        uint64_t tb0 = read_tb();
+        sys_timer_usleep(intervals[i]);
+        uint64_t tb1 = read_tb();
+        usecond_t t1 = sys_time_get_system_time();
+
+        double measured = (double)(tb1 - tb0) * 1000000.0 / (double)(t1 - t0);
+        double error = (measured - (double)freq) / (double)freq * 100.0;
+        // sleep granularity makes short intervals noisy, only flag big errors
+        int bad = error > 1.0 || error < -1.0;
+        printf("  %7llu us sleep: %llu ticks in %llu us -> %.0f Hz (%+.3f%%)%s\n",
+               (unsigned long long)intervals[i], (unsigned long long)(tb1 - tb0),
+               (unsigned long long)(t1 - t0), measured, error, bad ? "  FAIL" : "");
+        failed += bad;
+    }
+
+    // mftbu has to match the upper half of mftb, retry if the low word wrapped
+    uint64_t tb;
+    uint32_t tbu;
+    do {
+        tbu = read_tbu();
+        tb = read_tb();
+    } while ((uint32_t)(tb >> 32) != tbu && (uint32_t)tb < 0x1000);
+    int badTbu = (uint32_t)(tb >> 32) != tbu;
+    printf("  mftbu 0x%08x, mftb 0x%016llx%s\n", tbu, (unsigned long long)tb, badTbu ? "  FAIL" : "");
+    failed += badTbu;
+}
+
+/*
+ * Monotonicity across threads: every thread publishes the highest tb it has
+ * seen, a read that comes out lower than a value published before it was
+ * taken means the timebases aren't in sync
+ */
+static volatile uint64_t lastPublished __attribute__((aligned(128)));
+static volatile int startFlag;
+
+typedef struct {
+    uint64_t localBackwards;  // tb went backwards on the same thread
+    uint64_t crossBackwards;  // tb older than one another thread already published
+    uint64_t maxSkew;
+} mono_ctx_t;
+
+static mono_ctx_t monoCtx[NUM_THREADS];
+
+static void publish_max(uint64_t tb)
+{
+    uint64_t cur;
+    __asm__ volatile (
+        "1: ldarx %0,0,%2\n"
+        "   cmpld %0,%1\n"
+        "   bge 2f\n"
+        "   stdcx. %1,0,%2\n"
+        "   bne 1b\n"
+        "2:\n"
+        : "=&r"(cur) : "r"(tb), "r"(&lastPublished) : "cr0", "memory");
+}
+
+static void mono_thread(uint64_t arg)
+{
+    mono_ctx_t *c = &monoCtx[arg];
+    uint64_t prev = 0;
+
+    while (!startFlag)
+        sys_ppu_thread_yield();
+
+    for (int i = 0; i < READS_PER_THREAD; ++i) {
+        uint64_t seen = lastPublished;
+        __asm__ volatile ("sync" ::: "memory");
+        uint64_t tb = read_tb();
+        if (tb < prev)
+            c->localBackwards++;
+        if (tb < seen) {
+            c->crossBackwards++;
+            if (seen - tb > c->maxSkew)
+                c->maxSkew = seen - tb;
+        }
+        prev = tb;
+        // only publish now and then so the threads aren't just fighting over the line
+        if ((i & 63) == 0)
+            publish_max(tb);
+    }
+
+    sys_ppu_thread_exit(0);
+}
+
+static void test_monotonic(void)
+{
+    sys_ppu_thread_t threads[NUM_THREADS];
+    int ret;
+
+    printf("monotonicity over %d threads, %d reads each\n", NUM_THREADS, READS_PER_THREAD);
+
+    lastPublished = 0;
+    startFlag = 0;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        ret = sys_ppu_thread_create(&threads[i], mono_thread, i, 1000, 0x4000,
+                                    SYS_PPU_THREAD_CREATE_JOINABLE, "tb mono");
+        if (ret != CELL_OK) {
+            printf("sys_ppu_thread_create failed: %d\n", ret);
+            failed++;
+            return;
+        }
+    }
+    startFlag = 1;
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        uint64_t exitStatus;
+        sys_ppu_thread_join(threads[i], &exitStatus);
+        mono_ctx_t *c = &monoCtx[i];
+        int bad = c->localBackwards != 0 || c->crossBackwards != 0;
+        printf("  thread %d: %llu local backwards, %llu behind other threads (max %llu ticks)%s\n", i,
+               (unsigned long long)c->localBackwards, (unsigned long long)c->crossBackwards,
+               (unsigned long long)c->maxSkew, bad ? "  FAIL" : "");
+        failed += bad;
+    }
+}
+
+/*
+ * Read overhead and resolution: cost of back to back reads, and the
+ * smallest non zero step seen between them
+ */
+static void test_overhead(void)
+{
+    usecond_t t0 = sys_time_get_system_time();
+    uint64_t tb0 = read_tb();
+    for (int i = 0; i < OVERHEAD_READS; i += 8) {
+        read_tb(); read_tb(); read_tb(); read_tb();
+        read_tb(); read_tb(); read_tb(); read_tb();
+    }
+    uint64_t tb1 = read_tb();
+    usecond_t t1 = sys_time_get_system_time();
+
+    printf("read overhead: %.2f ns per mftb (%.4f ticks)\n",
+           (double)(t1 - t0) * 1000.0 / OVERHEAD_READS, (double)(tb1 - tb0) / OVERHEAD_READS);
+
+    uint64_t prev = read_tb();
+    uint64_t minStep = ~0ULL;
+    uint64_t maxStep = 0;
+    uint64_t same = 0;
+    for (int i = 0; i < OVERHEAD_READS; ++i) {
+        uint64_t tb = read_tb();
+        uint64_t step = tb - prev;
+        if (step == 0)
+            same++;
+        else if (step < minStep)
+            minStep = step;
+        if (step > maxStep)
+            maxStep = step;
+        prev = tb;
+    }
+    printf("resolution: min step %llu ticks, max step %llu ticks, %.1f%% of reads unchanged\n",
+           (unsigned long long)minStep, (unsigned long long)maxStep, (double)same * 100.0 / OVERHEAD_READS);
+}
+
+int main(void)
+{
+    printf("timebase calibration test\n");
+
+    test_rate();
+    test_monotonic();
+    test_overhead();
+
+    if (failed)
+        printf("%d checks failed\n", failed);
+    else
+        printf("timebase ok\n");
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <malloc.h>
+#include <altivec.h>
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+// Working set per kernel, small enough to stay in the 512KB L2
+#define BUF_SIZE (64 * 1024)
+#define NUM_VECS (BUF_SIZE / 16)
+#define PASSES 200
+
+typedef vector unsigned char vu8;
+typedef vector signed short vs16;
+typedef vector signed int vs32;
+typedef vector float vf32;
+
+static vu8 *srcBuf;
+static vu8 *dstBuf;
+
+static double tb_to_secs(uint64_t ticks)
+{
+    return (double)ticks / (double)sys_time_get_timebase_frequency();
+}
+
+static void print_result(const char *name, const char *unit, uint64_t ticks, uint64_t elements, int ok)
+{
+    double secs = tb_to_secs(ticks);
+    printf("%-24s %12.0f %s/s  (%.3f ms)%s\n", name, (double)elements / secs, unit, secs * 1000.0,
+           ok ? "" : "  MISMATCH");
+}
+
+/*
+ * vperm shuffles: byte swap 32 bit pixels and then interleave two vectors,
+ * the kind of thing done for texture and vertex stream conversion
+ */
+static void kernel_vperm(const vu8 *src, vu8 *dst, int count)
+{
+    const vu8 swap = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+    const vu8 mergeHi = { 0, 1, 2, 3, 16, 17, 18, 19, 4, 5, 6, 7, 20, 21, 22, 23 };
+    const vu8 mergeLo = { 8, 9, 10, 11, 24, 25, 26, 27, 12, 13, 14, 15, 28, 29, 30, 31 };
+
+    for (int i = 0; i < count; i += 2) {
+        vu8 a = vec_perm(src[i], src[i], swap);
+        vu8 b = vec_perm(src[i + 1], src[i + 1], swap);
+        dst[i] = vec_perm(a, b, mergeHi);
+        dst[i + 1] = vec_perm(a, b, mergeLo);
+    }
+}
+
+static int check_vperm(const uint32_t *src, const uint32_t *dst, int count)
+{
+    // each pair of vectors comes out as alternating swapped words of both
+    for (int i = 0; i < count * 4; i += 8) {
+        for (int j = 0; j < 4; ++j) {
+            if (dst[i + j * 2] != __builtin_bswap32(src[i + j]) ||
+                dst[i + j * 2 + 1] != __builtin_bswap32(src[i + 4 + j]))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * vmaddfp: AoS vertex transform by a 4x4 matrix, splat each component and
+ * accumulate the matrix columns
+ */
+static void kernel_vmaddfp(const vf32 *src, vf32 *dst, int count, const vf32 *mtx)
+{
+    const vf32 zero = (vf32){ -0.0f, -0.0f, -0.0f, -0.0f };
+    vf32 c0 = mtx[0], c1 = mtx[1], c2 = mtx[2], c3 = mtx[3];
+
+    for (int i = 0; i < count; ++i) {
+        vf32 v = src[i];
+        vf32 r = vec_madd(c0, vec_splat(v, 0), zero);
+        r = vec_madd(c1, vec_splat(v, 1), r);
+        r = vec_madd(c2, vec_splat(v, 2), r);
+        dst[i] = vec_madd(c3, vec_splat(v, 3), r);
+    }
+}
+
+static int check_vmaddfp(const float *src, const float *dst, int count, const float *mtx)
+{
+    for (int i = 0; i < count; ++i) {
+        const float *v = &src[i * 4];
+        for (int j = 0; j < 4; ++j) {
+            float expected = mtx[j] * v[0] + mtx[4 + j] * v[1] + mtx[8 + j] * v[2] + mtx[12 + j] * v[3];
+            if (fabsf(dst[i * 4 + j] - expected) > fabsf(expected) * 1e-5f + 1e-5f)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Saturating packs: float samples to u8 through vctsxs, vpkswss and
+ * vpkshus, every step can saturate. vctsxs takes NaN to 0
+ */
+static void kernel_pack(const vf32 *src, vu8 *dst, int count)
+{
+    for (int i = 0; i < count; i += 4) {
+        vs32 a = vec_cts(src[i], 0);
+        vs32 b = vec_cts(src[i + 1], 0);
+        vs32 c = vec_cts(src[i + 2], 0);
+        vs32 d = vec_cts(src[i + 3], 0);
+        vs16 lo = vec_packs(a, b);
+        vs16 hi = vec_packs(c, d);
+        dst[i >> 2] = vec_packsu(lo, hi);
+    }
+}
+
+static int check_pack(const float *src, const uint8_t *dst, int count)
+{
+    for (int i = 0; i < count * 4; ++i) {
+        float f = src[i];
+        int32_t v = f != f ? 0 : f >= 2147483647.0f ? 0x7FFFFFFF : f <= -2147483648.0f ? (int32_t)0x80000000 : (int32_t)f;
+        int32_t s = v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+        uint8_t expected = s > 255 ? 255 : s < 0 ? 0 : (uint8_t)s;
+        if (dst[i] != expected)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * lvx/stvx streaming copy, 4 quadwords per iteration
+ */
+static void kernel_stream(const vu8 *src, vu8 *dst, int count)
+{
+    for (int i = 0; i < count; i += 4) {
+        vu8 a = vec_ld(0, &src[i]);
+        vu8 b = vec_ld(16, &src[i]);
+        vu8 c = vec_ld(32, &src[i]);
+        vu8 d = vec_ld(48, &src[i]);
+        vec_st(a, 0, &dst[i]);
+        vec_st(b, 16, &dst[i]);
+        vec_st(c, 32, &dst[i]);
+        vec_st(d, 48, &dst[i]);
+    }
+}
+
+int main(void)
+{
+    srcBuf = memalign(128, BUF_SIZE);
+    dstBuf = memalign(128, BUF_SIZE);
+    if (srcBuf == NULL || dstBuf == NULL) {
+        printf("failed to allocate buffers\n");
+        return -1;
+    }
+
+    printf("VMX throughput benchmark, %d KB working set, %d passes\n", BUF_SIZE / 1024, PASSES);
+
+    // vperm
+    uint32_t *src32 = (uint32_t *)srcBuf;
+    for (int i = 0; i < BUF_SIZE / 4; ++i)
+        src32[i] = i * 0x01010101u + 0x00112233u;
+
+    uint64_t start = __mftb();
+    for (int p = 0; p < PASSES; ++p)
+        kernel_vperm(srcBuf, dstBuf, NUM_VECS);
+    uint64_t ticks = __mftb() - start;
+    print_result("vperm shuffle", "pixels", ticks, (uint64_t)PASSES * NUM_VECS * 4,
+                 check_vperm(src32, (uint32_t *)dstBuf, NUM_VECS));
+
+    // vmaddfp
+    static const float mtx[16] __attribute__((aligned(16))) = {
+        1.0f, 0.5f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.25f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        10.0f, 20.0f, 30.0f, 1.0f,
+    };
+    float *srcF = (float *)srcBuf;
+    for (int i = 0; i < BUF_SIZE / 4; ++i)
+        srcF[i] = (float)(i % 1000) * 0.125f - 50.0f;
+
+    start = __mftb();
+    for (int p = 0; p < PASSES; ++p)
+        kernel_vmaddfp((const vf32 *)srcBuf, (vf32 *)dstBuf, NUM_VECS, (const vf32 *)mtx);
+    ticks = __mftb() - start;
+    print_result("vmaddfp transform", "vertices", ticks, (uint64_t)PASSES * NUM_VECS,
+                 check_vmaddfp(srcF, (float *)dstBuf, NUM_VECS, mtx));
+
+    // saturating packs, mostly +-70000 for the packs with every 16th sample
+    // out of int32 range, infinite or NaN for vctsxs
+    static const float outOfRange[] = { 3e9f, -3e9f, 1e30f, -1e30f, INFINITY, -INFINITY, NAN, -NAN };
+    for (int i = 0; i < BUF_SIZE / 4; ++i)
+        srcF[i] = (float)((i * 7919) % 140000) - 70000.0f;
+    for (int i = 0; i < BUF_SIZE / 4; i += 16)
+        srcF[i] = outOfRange[(i / 16) % 8];
+
+    start = __mftb();
+    for (int p = 0; p < PASSES; ++p)
+        kernel_pack((const vf32 *)srcBuf, dstBuf, NUM_VECS);
+    ticks = __mftb() - start;
+    print_result("saturating pack", "floats", ticks, (uint64_t)PASSES * NUM_VECS * 4,
+                 check_pack(srcF, (uint8_t *)dstBuf, NUM_VECS));
+
+    // lvx/stvx
+    start = __mftb();
+    for (int p = 0; p < PASSES; ++p)
+        kernel_stream(srcBuf, dstBuf, NUM_VECS);
+    ticks = __mftb() - start;
+    print_result("lvx/stvx stream", "bytes", ticks, (uint64_t)PASSES * BUF_SIZE,
+                 memcmp(srcBuf, dstBuf, BUF_SIZE) == 0);
+
+    free(srcBuf);
+    free(dstBuf);
+    return 0;
+}
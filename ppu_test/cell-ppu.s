@@ -168,6 +168,22 @@ TEST_SC = 0
 TEST_TRAP = 0
 .endif
 
+# TEST_FPU_RC:  Set this to 1 to test the record forms (Rc=1) of the
+# floating-point arithmetic, rounding, conversion and fsel instructions
+# (frsp. through fsel.).  These tests verify that CR1 is updated from
+# FPSCR, including when the operation itself is aborted.
+.ifndef TEST_FPU_RC
+TEST_FPU_RC = 0
+.endif
+
+# TEST_MULH_OE:  Set this to 1 to test the mulhd, mulhw, mulhdu and mulhwu
+# instructions with the reserved OE bit set (0x7C694492, 0x7C694496,
+# 0x7C694412, 0x7C694416).  The instructions should execute normally and
+# leave XER unchanged.
+.ifndef TEST_MULH_OE
+TEST_MULH_OE = 0
+.endif
+
 # Convenience macros to load a 32-bit value into the low word (lvi) or all
 # words (lvia) of a vector register.  Destroys 0x7000..0x700F(%r4) and %r10.
 
@@ -4531,8 +4547,7 @@ get_load_address:
    # Cell processor raises an exception for mulh* instructions with both OE
    # and Rc set; those bit patterns are included below for reference,
    # bracketed by .if 0 / .endif so they are not actually executed.
-# todo: fix this opcode
-.if 0
+.if TEST_MULH_OE
 0: lis %r3,0x6000
    addis %r3,%r3,0x6000
    mtxer %r3
@@ -4544,7 +4559,7 @@ get_load_address:
    bl record
    li %r7,15
    bl check_alu_ov
-.endif
+.endif  # TEST_MULH_OE
    # These tests compute 2^77+1 (0x0000_0000_0000_2000_0000_0000_0000_0001)
    # as 1417634610809 * 106597092297 with various signs, and they will fail
    # if 128-bit multiplication is not correctly implemented.
@@ -4641,8 +4656,7 @@ get_load_address:
    bl record
    li %r7,0x1112
    bl check_alu
-#todo: fix this opcode
-.if 0
+.if TEST_MULH_OE
 0: lis %r3,0x6000
    addis %r3,%r3,0x6000
    mtxer %r3
@@ -4652,7 +4666,7 @@ get_load_address:
    bl record
    li %r7,15
    bl check_alu_ov
-.endif
+.endif  # TEST_MULH_OE
    # mulhw.
 0: lis %r8,3
    lis %r9,5
@@ -4716,8 +4730,7 @@ get_load_address:
    bl record
    li %r7,0x1112
    bl check_alu
-#todo: fix this opcode
-.if 0
+.if TEST_MULH_OE
 0: lis %r3,0x6000
    addis %r3,%r3,0x6000
    mtxer %r3
@@ -4729,7 +4742,7 @@ get_load_address:
    bl record
    li %r7,15
    bl check_alu_ov
-.endif
+.endif  # TEST_MULH_OE
    # mulhdu.
 0: li %r8,3
    sld %r8,%r8,%r31
@@ -4805,8 +4818,7 @@ get_load_address:
    bl record
    li %r7,0x1112
    bl check_alu
-#todo: fix this opcode
-.if 0
+.if TEST_MULH_OE
 0: lis %r3,0x6000
    addis %r3,%r3,0x6000
    mtxer %r3
@@ -4816,7 +4828,7 @@ get_load_address:
    bl record
    li %r7,15
    bl check_alu_ov
-.endif
+.endif  # TEST_MULH_OE
    # mulhwu.
 0: lis %r8,3
    lis %r9,5
@@ -10444,8 +10456,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: fix frsp.
-.if 0
+.if TEST_FPU_RC
    # frsp.
    # We assume frsp and frsp. share the same implementation and just check
    # that CR1 is updated properly (and likewise in tests below).
@@ -10486,7 +10497,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
    ########################################################################
    # 4.6.5.1 Floating-Point Elementary Arithmetic Instructions
    ########################################################################
@@ -10566,9 +10577,8 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
    # fadd.
-.if 0
+.if TEST_FPU_RC
 0: fadd. %f3,%f1,%f11   # normal + SNaN
    bl record
    mfcr %r3
@@ -10606,7 +10616,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fadds
 0: fadds %f3,%f1,%f25   # normal + normal
@@ -10658,8 +10668,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fadds.
 0: fadds. %f3,%f1,%f11  # normal + SNaN
    bl record
@@ -10677,7 +10686,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fsub
 0: fsub %f3,%f30,%f1    # normal - normal
@@ -10749,8 +10758,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fsub.
 0: fsub. %f3,%f1,%f11   # normal - SNaN
    bl record
@@ -10789,7 +10797,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fsubs
 0: lfd %f13,56(%r31)    # normal - normal
@@ -10838,8 +10846,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fsubs.
 0: fsubs. %f3,%f1,%f11  # normal - SNaN
    bl record
@@ -10857,7 +10864,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fmul
 0: fmul %f3,%f2,%f28    # normal * normal
@@ -10952,8 +10959,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fmul.
 0: fmul. %f3,%f1,%f11   # normal * SNaN
    bl record
@@ -10992,7 +10998,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fmuls
 0: fmuls %f3,%f2,%f29   # normal * normal
@@ -11070,8 +11076,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fmuls.
 0: fmuls. %f3,%f1,%f11  # normal * SNaN
    bl record
@@ -11089,7 +11094,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fdiv
 0: fdiv %f3,%f24,%f2    # normal / normal
@@ -11192,8 +11197,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fdiv.
 0: fdiv. %f3,%f1,%f11   # normal / SNaN
    bl record
@@ -11232,7 +11236,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fdivs
 0: fdivs %f3,%f25,%f2  # normal / normal
@@ -11292,8 +11296,7 @@ get_load_address:
    lfd %f4,0(%r4)
    bl check_fpu_pnorm_inex
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fdivs.
 0: fdivs. %f3,%f1,%f11  # normal / SNaN
    bl record
@@ -11311,7 +11314,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # This is a convenient place to check FPRF values for double-precision
    # denormals since we don't generate them anywhere else.
@@ -11508,8 +11511,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fmadd.
 0: fmadd. %f3,%f1,%f11,%f2  # normal * SNaN + normal
    bl record
@@ -11548,7 +11550,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fmadds
 0: fmadds %f3,%f2,%f29,%f1  # normal * normal + normal
@@ -11616,9 +11618,8 @@ get_load_address:
    lfd %f4,168(%r31)
    bl check_fpu_nan
 
-#todo: uncomment
    # fmadds.
-.if 0
+.if TEST_FPU_RC
 0: fmadds. %f3,%f1,%f11,%f2 # normal * SNaN + normal
    bl record
    mfcr %r3
@@ -11635,7 +11636,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fmsub
 0: fmsub %f3,%f1,%f30,%f1   # normal * normal - normal
@@ -11782,8 +11783,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fmsub.
 0: fmsub. %f3,%f1,%f11,%f2  # normal * SNaN - normal
    bl record
@@ -11822,7 +11822,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fmsubs
 0: fneg %f13,%f1            # normal * normal - -normal
@@ -11888,8 +11888,7 @@ get_load_address:
    lfd %f4,168(%r31)
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fmsubs.
 0: fmsubs. %f3,%f1,%f11,%f2 # normal * SNaN - normal
    bl record
@@ -11907,7 +11906,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fnmadd
 0: fnmadd %f3,%f2,%f28,%f1  # normal * normal + normal
@@ -12056,8 +12055,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_nnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fnmadd.
 0: fnmadd. %f3,%f1,%f11,%f2  # normal * SNaN + normal
    bl record
@@ -12096,7 +12094,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fnmadds
 0: fnmadds %f3,%f2,%f29,%f1 # normal * normal + normal
@@ -12164,8 +12162,7 @@ get_load_address:
    lfd %f4,168(%r31)
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fnmadds.
 0: fnmadds. %f3,%f1,%f11,%f2 # normal * SNaN + normal
    bl record
@@ -12183,7 +12180,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fnmsub
 0: fnmsub %f3,%f1,%f30,%f1  # normal * normal - normal
@@ -12329,8 +12326,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_nnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fnmsub.
 0: fnmsub. %f3,%f1,%f11,%f2  # normal * SNaN - normal
    bl record
@@ -12369,7 +12365,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fnmsubs
 0: fneg %f13,%f1            # normal * normal - -normal
@@ -12435,8 +12431,7 @@ get_load_address:
    lfd %f4,168(%r31)
    bl check_fpu_nan
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fnmsubs.
 0: fnmsubs. %f3,%f1,%f11,%f2 # normal * SNaN - normal
    bl record
@@ -12454,7 +12449,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    ########################################################################
    # 4.6.6 Floating-Point Rounding and Conversion Instructions - fcti*
@@ -12633,8 +12628,7 @@ get_load_address:
    bl add_fpscr_vxcvi
    bl check_fctid
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fctid.
 0: fctid. %f3,%f11  # SNaN
    bl record
@@ -12675,7 +12669,7 @@ get_load_address:
    bl add_fpscr_vxcvi
    bl check_fpu_noresult_nofprf
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fctidz
 0: fctidz %f3,%f24
@@ -12687,8 +12681,7 @@ get_load_address:
    mr %r7,%r26
    bl check_fctid_inex
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fctidz.
 0: fctidz. %f3,%f11
    bl record
@@ -12707,7 +12700,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl add_fpscr_vxcvi
    bl check_fctid
-.endif
+.endif  # TEST_FPU_RC
 
    # fctiw (RN = round to nearest)
 0: fctiw %f3,%f0
@@ -12862,8 +12855,7 @@ get_load_address:
    bl add_fpscr_vxcvi
    bl check_fctiw
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fctiw.
 0: fctiw. %f3,%f11  # SNaN
    bl record
@@ -12904,7 +12896,7 @@ get_load_address:
    bl add_fpscr_vxcvi
    bl check_fpu_noresult_nofprf
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fctiwz
 0: fctiwz %f3,%f24
@@ -12916,8 +12908,7 @@ get_load_address:
    mr %r7,%r26
    bl check_fctiw_inex
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fctiwz.
 0: fctiwz. %f3,%f11
    bl record
@@ -12936,7 +12927,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl add_fpscr_vxcvi
    bl check_fctiw
-.endif
+.endif  # TEST_FPU_RC
 
    ########################################################################
    # 4.6.6 Floating-Point Rounding and Conversion Instructions - fcfid
@@ -12982,11 +12973,10 @@ get_load_address:
    lfd %f4,0(%r4)
    bl check_fpu_nnorm
 
-#todo: uncomment
    # fcfid.
    # This instruction can't generate exceptions, so use another insn to
    # prime FPSCR so we can usefully check CR1.
-.if 0
+.if TEST_FPU_RC
 0: fdiv %f3,%f0,%f0
    fcfid. %f3,%f0
    bl record
@@ -13004,7 +12994,7 @@ get_load_address:
 1: fmr %f4,%f0
    bl add_fpscr_vxzdz
    bl check_fpu_pzero
-.endif
+.endif  # TEST_FPU_RC
 
    ########################################################################
    # 5.1.1 (Optional) Move To/From System Register Instructions
@@ -13122,8 +13112,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_pnorm
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fsqrt.
 0: fsqrt. %f3,%f11      # SNaN
    bl record
@@ -13162,7 +13151,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # fsqrts
    # The square root of any base-2 rational number will always have fewer
@@ -13174,8 +13163,7 @@ get_load_address:
    lfs %f4,8(%r30)
    bl check_fpu_pnorm_inex
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fsqrts.
 0: fsqrts. %f3,%f11     # SNaN
    bl record
@@ -13193,7 +13181,7 @@ get_load_address:
 1: fmr %f4,%f12
    bl add_fpscr_vxsnan
    bl check_fpu_nan
-.endif
+.endif  # TEST_FPU_RC
 
    # fres
 0: fres %f3,%f2         # +normal
@@ -13281,8 +13269,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_estimate
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fres.
 0: fres. %f3,%f11       # SNaN
    bl record
@@ -13321,7 +13308,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    # frsqrte
    # FIXME: Figure out the actual algorithm used by the hardware and test
@@ -13414,8 +13401,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_estimate
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # frsqrte.
 0: frsqrte. %f3,%f11    # SNaN
    bl record
@@ -13454,7 +13440,7 @@ get_load_address:
    bl add_fpscr_vxsnan
    bl check_fpu_noresult
    mtfsb0 24
-.endif
+.endif  # TEST_FPU_RC
 
    ########################################################################
    # 5.2.2 (Optional) Floating-Point Select Instruction
@@ -13517,8 +13503,7 @@ get_load_address:
    stfd %f3,8(%r6)
    addi %r6,%r6,32
 
-#todo: uncomment
-.if 0
+.if TEST_FPU_RC
    # fsel.
 0: li %r0,0
    mtcr %r0
@@ -13534,7 +13519,7 @@ get_load_address:
 1: stfd %f3,8(%r6)
    std %r3,16(%r6)
    addi %r6,%r6,32
-.endif
+.endif  # TEST_FPU_RC
 
    ########################################################################
    # Book II 3.2.1 Instruction Cache Instruction
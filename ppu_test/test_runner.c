@@ -5,8 +5,185 @@
 #define __CELL_ASSERT__ 
 #include <assert.h>
 
+#if defined(TEST_SC) || defined(TEST_TRAP) || defined(TEST_BA) || defined(TEST_FPU_RC)
+#include <ppu_intrinsics.h>
+#include <sys/sys_time.h>
+#endif
+
 extern int test(int zero, void *scratch, void *failures, double one);
 
+#if defined(TEST_SC) || defined(TEST_TRAP) || defined(TEST_BA) || defined(TEST_FPU_RC)
+#define TIMING_LOOPS 100000
+
+// Converts a timebase delta into nanoseconds per iteration
+static double tb_to_ns(uint64_t ticks, uint32_t loops)
+{
+    return (double)ticks * 1000000000.0 / (double)sys_time_get_timebase_frequency() / loops;
+}
+#endif
+
+#ifdef TEST_SC
+// Same sequence cell-ppu.s checks, r11 is set to sys_process_getpid so the
+// round trip is also meaningful on an lv2 that dispatches on r11
+static void time_sc(void)
+{
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) {
+        __asm__ volatile (
+            "li 11,1\n"
+            "li 3,-1\n"
+            "sc\n"
+            ::: "r0", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12",
+                "cr0", "ctr", "xer", "memory");
+    }
+    uint64_t ticks = __mftb() - start;
+    printf("sc round trip: %.1f ns (%d iterations)\n", tb_to_ns(ticks, TIMING_LOOPS), TIMING_LOOPS);
+}
+#endif
+
+#ifdef TEST_TRAP
+// Times the trap instructions both when the condition doesn't hold (decode
+// cost only) and when it does (full round trip through the trap handler)
+static void time_trap(void)
+{
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) {
+        __asm__ volatile ("li 3,-1\n tw 16,3,3\n" ::: "r3", "memory");
+    }
+    uint64_t notTaken = __mftb() - start;
+
+    start = __mftb();
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) {
+        __asm__ volatile ("li 3,-1\n tw 4,3,3\n" ::: "r3", "memory");
+    }
+    uint64_t taken = __mftb() - start;
+
+    start = __mftb();
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) {
+        __asm__ volatile ("li 3,-1\n tdi 4,3,-1\n" ::: "r3", "memory");
+    }
+    uint64_t takenImm = __mftb() - start;
+
+    printf("tw not taken: %.1f ns\n", tb_to_ns(notTaken, TIMING_LOOPS));
+    printf("tw taken round trip: %.1f ns\n", tb_to_ns(taken, TIMING_LOOPS));
+    printf("tdi taken round trip: %.1f ns\n", tb_to_ns(takenImm, TIMING_LOOPS));
+}
+#endif
+
+#ifdef TEST_BA
+// get_load_address in cell-ppu.s lives at 0x1000010 when TEST_BA is set,
+// so it can be called directly with bla
+static void time_ba(void)
+{
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) {
+        __asm__ volatile ("bla 0x1000010\n" ::: "r0", "r3", "lr", "memory");
+    }
+    uint64_t ticks = __mftb() - start;
+    printf("bla/blr round trip: %.1f ns (%d iterations)\n", tb_to_ns(ticks, TIMING_LOOPS), TIMING_LOOPS);
+}
+#endif
+
+#ifdef TEST_FPU_RC
+// Failure records coming from the TEST_FPU_RC / TEST_MULH_OE blocks of
+// cell-ppu.s. The rest of the suite has record forms too (mffs., mtfsf.,
+// fmr., fabs. ...), so only the exact instructions those blocks add count
+static int is_rc_record(uint32_t inst)
+{
+    uint32_t primary = inst >> 26;
+    uint32_t xo = (inst >> 1) & 0x3FF;
+    if (!(inst & 1) || (primary != 59 && primary != 63))
+        return inst == 0x7C694492 || inst == 0x7C694496 || inst == 0x7C694412 || inst == 0x7C694416;
+
+    // A-form: fdiv(s) fsub(s) fadd(s) fsqrt(s) fsel fres fmul(s) frsqrte
+    // fmsub(s) fmadd(s) fnmsub(s) fnmadd(s)
+    switch (xo & 0x1F) {
+    case 18: case 20: case 21: case 22: case 25:
+    case 28: case 29: case 30: case 31:
+        return 1;
+    case 23: case 26:
+        return primary == 63;
+    case 24:
+        return primary == 59;
+    }
+    // X-form: frsp fctiw fctiwz fctid fctidz fcfid
+    return primary == 63 && (xo == 12 || xo == 14 || xo == 15 || xo == 814 || xo == 815 || xo == 846);
+}
+
+static void print_rc_timing(const char *name, uint64_t plain, uint64_t rc)
+{
+    double plainNs = tb_to_ns(plain, TIMING_LOOPS);
+    double rcNs = tb_to_ns(rc, TIMING_LOOPS);
+    printf("%-8s %8.2f ns  %-9s %8.2f ns  (+%.2f ns)\n", name, plainNs, "record:", rcNs, rcNs - plainNs);
+}
+
+// Times a floating point instruction against its record form, operands are
+// clean values so neither form raises an exception
+#define TIME_FPU_RC(name, plainInsn, rcInsn) do { \
+    uint64_t start = __mftb(); \
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) \
+        __asm__ volatile (plainInsn : "=f"(r) : "f"(a), "f"(b), "f"(c)); \
+    uint64_t plain = __mftb() - start; \
+    start = __mftb(); \
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) \
+        __asm__ volatile (rcInsn : "=f"(r) : "f"(a), "f"(b), "f"(c) : "cr1"); \
+    print_rc_timing(name, plain, __mftb() - start); \
+} while (0)
+
+// Same for mulh*, the OE forms are encoded directly as in cell-ppu.s
+#define TIME_MULH_OE(name, plainInsn, oeWord) do { \
+    uint64_t start = __mftb(); \
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) \
+        __asm__ volatile ("li 8,3\n li 9,5\n" plainInsn ::: "r3", "r8", "r9"); \
+    uint64_t plain = __mftb() - start; \
+    start = __mftb(); \
+    for (uint32_t i = 0; i < TIMING_LOOPS; ++i) \
+        __asm__ volatile ("li 8,3\n li 9,5\n .int " #oeWord ::: "r3", "r8", "r9", "xer"); \
+    print_rc_timing(name, plain, __mftb() - start); \
+} while (0)
+
+static void time_fpu_rc(void)
+{
+    double a = 1.5, b = 2.25, c = 0.75, r;
+
+    printf("per instruction timing, %d iterations each\n", TIMING_LOOPS);
+    TIME_FPU_RC("frsp", "frsp %0,%1", "frsp. %0,%1");
+    TIME_FPU_RC("fadd", "fadd %0,%1,%2", "fadd. %0,%1,%2");
+    TIME_FPU_RC("fadds", "fadds %0,%1,%2", "fadds. %0,%1,%2");
+    TIME_FPU_RC("fsub", "fsub %0,%1,%2", "fsub. %0,%1,%2");
+    TIME_FPU_RC("fsubs", "fsubs %0,%1,%2", "fsubs. %0,%1,%2");
+    TIME_FPU_RC("fmul", "fmul %0,%1,%2", "fmul. %0,%1,%2");
+    TIME_FPU_RC("fmuls", "fmuls %0,%1,%2", "fmuls. %0,%1,%2");
+    TIME_FPU_RC("fdiv", "fdiv %0,%1,%2", "fdiv. %0,%1,%2");
+    TIME_FPU_RC("fdivs", "fdivs %0,%1,%2", "fdivs. %0,%1,%2");
+    TIME_FPU_RC("fmadd", "fmadd %0,%1,%2,%3", "fmadd. %0,%1,%2,%3");
+    TIME_FPU_RC("fmadds", "fmadds %0,%1,%2,%3", "fmadds. %0,%1,%2,%3");
+    TIME_FPU_RC("fmsub", "fmsub %0,%1,%2,%3", "fmsub. %0,%1,%2,%3");
+    TIME_FPU_RC("fmsubs", "fmsubs %0,%1,%2,%3", "fmsubs. %0,%1,%2,%3");
+    TIME_FPU_RC("fnmadd", "fnmadd %0,%1,%2,%3", "fnmadd. %0,%1,%2,%3");
+    TIME_FPU_RC("fnmadds", "fnmadds %0,%1,%2,%3", "fnmadds. %0,%1,%2,%3");
+    TIME_FPU_RC("fnmsub", "fnmsub %0,%1,%2,%3", "fnmsub. %0,%1,%2,%3");
+    TIME_FPU_RC("fnmsubs", "fnmsubs %0,%1,%2,%3", "fnmsubs. %0,%1,%2,%3");
+    TIME_FPU_RC("fctid", "fctid %0,%1", "fctid. %0,%1");
+    TIME_FPU_RC("fctidz", "fctidz %0,%1", "fctidz. %0,%1");
+    TIME_FPU_RC("fctiw", "fctiw %0,%1", "fctiw. %0,%1");
+    TIME_FPU_RC("fctiwz", "fctiwz %0,%1", "fctiwz. %0,%1");
+    TIME_FPU_RC("fcfid", "fcfid %0,%1", "fcfid. %0,%1");
+    TIME_FPU_RC("fsqrt", "fsqrt %0,%1", "fsqrt. %0,%1");
+    TIME_FPU_RC("fsqrts", "fsqrts %0,%1", "fsqrts. %0,%1");
+    TIME_FPU_RC("fres", "fres %0,%1", "fres. %0,%1");
+    TIME_FPU_RC("frsqrte", "frsqrte %0,%1", "frsqrte. %0,%1");
+    TIME_FPU_RC("fsel", "fsel %0,%1,%2,%3", "fsel. %0,%1,%2,%3");
+    (void)r;
+
+    printf("mulh* against the reserved OE bit forms\n");
+    TIME_MULH_OE("mulhd", "mulhd 3,9,8", 0x7C694492);
+    TIME_MULH_OE("mulhw", "mulhw 3,9,8", 0x7C694496);
+    TIME_MULH_OE("mulhdu", "mulhdu 3,9,8", 0x7C694412);
+    TIME_MULH_OE("mulhwu", "mulhwu 3,9,8", 0x7C694416);
+}
+#endif
+
 int main(void)
 {   
     char *scratchBuf = malloc(32768);
@@ -18,9 +195,25 @@ int main(void)
 
     if (ret == 0) {
         printf("No failures detected!\n");
+#ifdef TEST_SC
+        time_sc();
+#endif
+#ifdef TEST_TRAP
+        time_trap();
+#endif
+#ifdef TEST_BA
+        time_ba();
+#endif
+#ifdef TEST_FPU_RC
+        time_fpu_rc();
+#endif
     }
     else if (ret < 0) {
         printf("Code failed to bootstrap itself\n");
+#ifdef TEST_BA
+        if (ret == -256)
+            printf("TEST_BA requires load at 0x1000000, check test_ba.ld\n");
+#endif
     }
     else {
         // excerpt from cell-ppu.s , see file for more info
@@ -36,15 +229,29 @@ int main(void)
         # in different locations; in such cases, use the address to locate the
         # failing instruction.*/
         printf("%d failed instructions\n", ret);
+#ifdef TEST_FPU_RC
+        int rcFailed = 0;
+        for (int i = 0; i < ret; ++i)
+            rcFailed += is_rc_record(((uint32_t*)failedBuf)[i * 8]);
+        printf("%d in record form / mulh OE tests, %d in the rest of the suite\n", rcFailed, ret - rcFailed);
+#endif
         uint32_t *fail = (uint32_t*)failedBuf;
         for (int i=0; i < ret; ++i) {
             printf("-------------------------------------------\n");
+#ifdef TEST_FPU_RC
+            if (is_rc_record(fail[0]))
+                printf("[record form] ");
+#endif
             printf("Failed inst: 0x%x, addr 0x%x\n", fail[0], fail[1]);
             printf("Aux Data: 0x%x 0x%x\n", fail[2], fail[3]);
             printf("0x%x 0x%x 0x%x 0x%x\n", fail[4], fail[5], fail[6], fail[7]);
             fail += 8;
         }
 
+#ifdef TEST_FPU_RC
+        // the record forms don't hang on failure, so still time them
+        time_fpu_rc();
+#endif
         printf("Throwing assert\n");
         assert(0);
     }
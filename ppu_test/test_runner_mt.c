@@ -0,0 +1,160 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#define __CELL_ASSERT__
+#include <assert.h>
+
+#include <sys/ppu_thread.h>
+#include <sys/sys_time.h>
+
+extern int test(int zero, void *scratch, void *failures, double one);
+
+// Number of ppu threads running the suite concurrently
+#ifndef NUM_THREADS
+#define NUM_THREADS 4
+#endif
+
+// Times each thread runs the whole suite, more runs means more chances for
+// the threads to interleave inside the lwarx/stwcx. tests
+#ifndef ITERATIONS
+#define ITERATIONS 8
+#endif
+
+#define SCRATCH_SIZE 32768
+#define FAILED_SIZE 65536
+
+typedef struct {
+    int index;
+    char *scratchBuf;
+    char *failedBuf;
+    char *spareBuf;   // failure buffer for runs after the first failing one
+    int ret;          // result of the first failing run, or 0
+    int failedRuns;
+    usecond_t elapsed;
+} thread_ctx_t;
+
+static thread_ctx_t ctx[NUM_THREADS];
+static volatile int startFlag = 0;
+
+static void test_thread(uint64_t arg)
+{
+    thread_ctx_t *c = &ctx[arg];
+
+    // wait for every thread to be created so they actually run together
+    while (!startFlag)
+        sys_ppu_thread_yield();
+
+    usecond_t start = sys_time_get_system_time();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        // cell-ppu.s expects a pre-cleared scratch block on every call
+        memset(c->scratchBuf, 0, SCRATCH_SIZE);
+
+        // the suite clears a record slot before every test, so once a run has
+        // failed its records are kept and later runs go to the spare buffer
+        char *failedBuf = c->failedRuns ? c->spareBuf : c->failedBuf;
+        int ret = test(0, c->scratchBuf, failedBuf, (double)1.0);
+        if (ret != 0) {
+            if (c->failedRuns == 0)
+                c->ret = ret;
+            c->failedRuns++;
+            if (ret < 0)
+                break;
+        }
+    }
+    c->elapsed = sys_time_get_system_time() - start;
+
+    sys_ppu_thread_exit(0);
+}
+
+static void print_failures(thread_ctx_t *c)
+{
+    uint32_t *fail = (uint32_t*)c->failedBuf;
+    for (int i = 0; i < c->ret; ++i) {
+        printf("-------------------------------------------\n");
+        printf("[thread %d] Failed inst: 0x%x, addr 0x%x\n", c->index, fail[0], fail[1]);
+        printf("Aux Data: 0x%x 0x%x\n", fail[2], fail[3]);
+        printf("0x%x 0x%x 0x%x 0x%x\n", fail[4], fail[5], fail[6], fail[7]);
+        fail += 8;
+    }
+}
+
+int main(void)
+{
+    sys_ppu_thread_t threads[NUM_THREADS];
+    int ret;
+
+    printf("Starting / Running tests on %d threads, %d iterations each\n", NUM_THREADS, ITERATIONS);
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        ctx[i].index = i;
+        // scratch has to be cache aligned, and the lwarx tests shouldn't
+        // share a reservation granule with another thread's buffer
+        ctx[i].scratchBuf = memalign(128, SCRATCH_SIZE);
+        ctx[i].failedBuf = memalign(128, FAILED_SIZE);
+        ctx[i].spareBuf = memalign(128, FAILED_SIZE);
+        ctx[i].ret = 0;
+        ctx[i].failedRuns = 0;
+        ctx[i].elapsed = 0;
+        if (ctx[i].scratchBuf == NULL || ctx[i].failedBuf == NULL || ctx[i].spareBuf == NULL) {
+            printf("failed to allocate buffers for thread %d\n", i);
+            return -1;
+        }
+
+        ret = sys_ppu_thread_create(&threads[i], test_thread, i, 1000, 0x4000,
+                                    SYS_PPU_THREAD_CREATE_JOINABLE, "test ppu thread");
+        if (ret != CELL_OK) {
+            printf("sys_ppu_thread_create failed: %d\n", ret);
+            return ret;
+        }
+    }
+
+    usecond_t start = sys_time_get_system_time();
+    startFlag = 1;
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        uint64_t exitStatus;
+        ret = sys_ppu_thread_join(threads[i], &exitStatus);
+        if (ret != CELL_OK) {
+            printf("sys_ppu_thread_join failed: %d\n", ret);
+            return ret;
+        }
+    }
+    usecond_t wall = sys_time_get_system_time() - start;
+
+    int totalFailedRuns = 0;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        thread_ctx_t *c = &ctx[i];
+        printf("thread %d: %d/%d runs failed, %llu us\n", i, c->failedRuns, ITERATIONS,
+               (unsigned long long)c->elapsed);
+        totalFailedRuns += c->failedRuns;
+    }
+    printf("wall time: %llu us for %d suite runs (%.1f us per run)\n", (unsigned long long)wall,
+           NUM_THREADS * ITERATIONS, (double)wall / (NUM_THREADS * ITERATIONS));
+
+    if (totalFailedRuns == 0) {
+        printf("No failures detected!\n");
+    }
+    else {
+        for (int i = 0; i < NUM_THREADS; ++i) {
+            thread_ctx_t *c = &ctx[i];
+            if (c->ret < 0)
+                printf("[thread %d] Code failed to bootstrap itself\n", i);
+            else if (c->ret > 0) {
+                printf("[thread %d] %d failed instructions in first failing run\n", i, c->ret);
+                print_failures(c);
+            }
+        }
+
+        printf("Throwing assert\n");
+        assert(0);
+    }
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        free(ctx[i].scratchBuf);
+        free(ctx[i].failedBuf);
+        free(ctx[i].spareBuf);
+    }
+    return 0;
+}
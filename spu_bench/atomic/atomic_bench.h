@@ -0,0 +1,25 @@
+/*
+ * Shared between atomic_bench.spu.c and atomic_bench.ppu.c. Everyone
+ * works on one 128 byte line in main memory, the PPU is participant 0 and
+ * SPU thread i is participant i + 1
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define ATOMIC_OPS 100000
+
+enum {
+    ATOMIC_SHARED,          // everyone increments word 0
+    ATOMIC_FALSE_SHARED,    // participant p increments word p
+    ATOMIC_LOCK,            // word 0 is a lock, word 1 the counter it protects
+    ATOMIC_MODE_COUNT
+};
+
+// SPU arguments: arg1 line ea, arg2 mode, arg3 participant, arg4 result ea
+typedef struct {
+    uint32_t ops;
+    uint32_t lost;          // PUTLLC that lost the reservation
+    uint32_t ticks;
+    uint32_t pad;
+} atomic_result_t __attribute__((aligned(16)));
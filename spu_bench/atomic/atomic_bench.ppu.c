@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ppu_intrinsics.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "atomic_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_atomic_bench_spu_out_start[];
+
+static const char *modeNames[ATOMIC_MODE_COUNT] = { "shared", "false shared", "lock" };
+
+static volatile uint32_t line[32] __attribute__((aligned(128)));
+static atomic_result_t results[SPU_BENCH_MAX_THREADS];
+
+// same loops as ppu_bench/reservation, returns failed stwcx.
+static inline uint32_t atomic_inc32(volatile uint32_t *p)
+{
+    uint32_t tmp, fails = 0;
+    __asm__ volatile (
+        "1: lwarx %0,0,%2\n"
+        "   addi %0,%0,1\n"
+        "   stwcx. %0,0,%2\n"
+        "   beq 2f\n"
+        "   addi %1,%1,1\n"
+        "   b 1b\n"
+        "2:\n"
+        : "=&r"(tmp), "+r"(fails) : "r"(p) : "cr0", "memory");
+    return fails;
+}
+
+// spins while the lock is held, only failed stwcx. are counted
+static inline uint32_t locked_inc32(volatile uint32_t *l)
+{
+    uint32_t tmp, fails = 0;
+    __asm__ volatile (
+        "1: lwarx %0,0,%2\n"
+        "   cmpwi %0,0\n"
+        "   bne 1b\n"
+        "   li %0,1\n"
+        "   stwcx. %0,0,%2\n"
+        "   beq 2f\n"
+        "   addi %1,%1,1\n"
+        "   b 1b\n"
+        "2: isync\n"
+        : "=&r"(tmp), "+r"(fails) : "r"(l) : "cr0", "memory");
+    l[1]++;
+    __lwsync();
+    l[0] = 0;
+    return fails;
+}
+
+static uint32_t ppu_ops(int mode)
+{
+    uint32_t lost = 0;
+    for (int i = 0; i < ATOMIC_OPS; ++i) {
+        if (mode == ATOMIC_LOCK)
+            lost += locked_inc32(line);
+        else
+            lost += atomic_inc32(&line[0]);     // participant 0 uses word 0 either way
+    }
+    return lost;
+}
+
+/*
+ * One run with numSpus SPU threads and optionally the PPU, all hammering
+ * the line. Returns 1 if the final counts are off
+ */
+static int run(int mode, int withPpu, int numSpus)
+{
+    sys_spu_thread_argument_t args[SPU_BENCH_MAX_THREADS];
+    spu_bench_group_t g;
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+    int ret;
+
+    memset((void *)line, 0, sizeof(line));
+    memset(results, 0, sizeof(results));
+    memset(args, 0, sizeof(args));
+    for (int i = 0; i < numSpus; ++i) {
+        args[i].arg1 = (uint64_t)(uintptr_t)line;
+        args[i].arg2 = mode;
+        args[i].arg3 = i + 1;
+        args[i].arg4 = (uint64_t)(uintptr_t)&results[i];
+    }
+
+    if (numSpus > 0 && (ret = spu_bench_start(&g, _binary_atomic_bench_spu_out_start, numSpus, args)) != CELL_OK)
+        return ret;
+
+    uint64_t start = __mftb();
+    for (int i = 0; i < numSpus; ++i)
+        sys_spu_thread_write_spu_mb(g.threads[i], 1);
+    uint32_t ppuLost = withPpu ? ppu_ops(mode) : 0;
+    if (numSpus > 0 && (ret = spu_bench_join(&g, NULL)) != CELL_OK)
+        return ret;
+    uint64_t ticks = __mftb() - start;
+
+    uint64_t spuOps = 0, spuLost = 0;
+    for (int i = 0; i < numSpus; ++i) {
+        spuOps += results[i].ops;
+        spuLost += results[i].lost;
+    }
+    uint64_t total = spuOps + (withPpu ? ATOMIC_OPS : 0);
+
+    // every participant's updates have to be there
+    int bad = 0;
+    if (mode == ATOMIC_SHARED)
+        bad = line[0] != total;
+    else if (mode == ATOMIC_LOCK)
+        bad = line[1] != total || line[0] != 0;
+    else {
+        bad = withPpu && line[0] != ATOMIC_OPS;
+        for (int i = 0; i < numSpus; ++i)
+            bad |= line[i + 1] != ATOMIC_OPS;
+    }
+
+    double secs = (double)ticks / (double)tbFreq;
+    printf("%-12s %d ppu + %d spu: %10.0f updates/s, lost per update ppu %6.3f spu %6.3f%s\n",
+           modeNames[mode], withPpu, numSpus, (double)total / secs,
+           withPpu ? (double)ppuLost / ATOMIC_OPS : 0.0,
+           spuOps ? (double)spuLost / (double)spuOps : 0.0,
+           bad ? "  LOST UPDATES" : "");
+    return bad;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    printf("spu atomic contention benchmark, %d updates per participant\n", ATOMIC_OPS);
+
+    for (int mode = 0; mode < ATOMIC_MODE_COUNT; ++mode) {
+        for (int withPpu = 0; withPpu < 2; ++withPpu) {
+            for (int n = withPpu ? 0 : 1; n <= SPU_BENCH_MAX_THREADS; ++n) {
+                int ret = run(mode, withPpu, n);
+                if (ret < 0) {
+                    spu_bench_finalize();
+                    return ret;
+                }
+                failed += ret;
+            }
+        }
+    }
+
+    spu_bench_finalize();
+    if (failed)
+        printf("%d runs lost updates!\n", failed);
+    else
+        printf("done, no lost updates\n");
+    return failed ? 1 : 0;
+}
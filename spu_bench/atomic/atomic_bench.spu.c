@@ -0,0 +1,96 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+#include "atomic_bench.h"
+
+// LS copy of the reservation granule
+static volatile uint32_t line[32] __attribute__((aligned(128)));
+static atomic_result_t result;
+
+static inline void getllar(uint64_t ea)
+{
+    mfc_getllar(line, ea, 0, 0);
+    mfc_read_atomic_status();
+}
+
+// non zero if the reservation was lost and nothing was written
+static inline uint32_t putllc(uint64_t ea)
+{
+    mfc_putllc(line, ea, 0, 0);
+    return mfc_read_atomic_status() & MFC_PUTLLC_STATUS;
+}
+
+static inline void putlluc(uint64_t ea)
+{
+    mfc_putlluc(line, ea, 0, 0);
+    mfc_read_atomic_status();
+}
+
+static uint32_t atomic_inc(uint64_t ea, int word)
+{
+    uint32_t lost = 0;
+    for (;;) {
+        getllar(ea);
+        line[word]++;
+        if (!putllc(ea))
+            return lost;
+        ++lost;
+    }
+}
+
+/*
+ * Lock with GETLLAR/PUTLLC, then update and release in one PUTLLUC the way
+ * the spu mutexes do. Spinning on a held lock isn't counted as lost
+ */
+static uint32_t locked_inc(uint64_t ea)
+{
+    uint32_t lost = 0;
+    for (;;) {
+        getllar(ea);
+        if (line[0] != 0)
+            continue;
+        line[0] = 1;
+        if (!putllc(ea))
+            break;
+        ++lost;
+    }
+    // nobody else writes the line while we hold it, so line is current
+    line[1]++;
+    line[0] = 0;
+    putlluc(ea);
+    return lost;
+}
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    uint64_t lineEa = arg1;
+    int mode = (int)arg2;
+    int participant = (int)arg3;
+    uint64_t resultEa = arg4;
+
+    dec_init();
+
+    // everyone starts together when the PPU says go
+    spu_read_in_mbox();
+
+    uint32_t start = dec_read();
+    for (uint32_t i = 0; i < ATOMIC_OPS; ++i) {
+        switch (mode) {
+        case ATOMIC_SHARED:
+            result.lost += atomic_inc(lineEa, 0);
+            break;
+        case ATOMIC_FALSE_SHARED:
+            result.lost += atomic_inc(lineEa, participant);
+            break;
+        default:
+            result.lost += locked_inc(lineEa);
+            break;
+        }
+    }
+    result.ticks = dec_elapsed(start, dec_read());
+    result.ops = ATOMIC_OPS;
+
+    dma_put_wait(&result, resultEa, sizeof(result));
+    sys_spu_thread_exit(0);
+    return 0;
+}
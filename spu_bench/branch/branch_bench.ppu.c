@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../common/spu_bench_ppu.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_branch_bench_spu_out_start[];
+
+int main(void)
+{
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg2 = sys_time_get_timebase_frequency();
+
+    int ret = spu_bench_run(_binary_branch_bench_spu_out_start, 1, &args);
+    spu_bench_finalize();
+    return ret;
+}
@@ -0,0 +1,201 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+
+#define ITERATIONS 100000
+#define TAG 0
+
+/*
+ * The asm loops come in pairs that only differ in the hint: the hinted one
+ * has an hbr/hbrr at the top, the other an lnop in its place. 10 nop/lnop
+ * pairs keep the hint far enough ahead of its branch. Unhinted taken
+ * branches cost the full mispredict on hardware
+ */
+#define PAD ".rept 10\n\tnop\n\tlnop\n\t.endr\n\t"
+
+// Counted loop, the back edge is a relative brnz
+#define REL_LOOP(id, hint) \
+static uint32_t id(void) \
+{ \
+    uint32_t n = ITERATIONS; \
+    uint32_t start = dec_read(); \
+    __asm__ volatile ( \
+        "1: " hint "\n\t" PAD \
+        "ai %0,%0,-1\n\t" \
+        "3: brnz %0,1b\n\t" \
+        : "+r"(n)); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+REL_LOOP(rel_hinted, "hbrr 3f,1b")
+REL_LOOP(rel_unhinted, "lnop")
+
+// The same loop with an indirect bi back edge, exits through a brz that is never taken until the end
+#define BI_LOOP(id, hint) \
+static uint32_t id(void) \
+{ \
+    uint32_t n = ITERATIONS, target; \
+    uint32_t start = dec_read(); \
+    __asm__ volatile ( \
+        "ila %1,1f\n\t" \
+        "1: " hint "\n\t" PAD \
+        "ai %0,%0,-1\n\t" \
+        "brz %0,4f\n\t" \
+        "3: bi %1\n\t" \
+        "4:\n\t" \
+        : "+r"(n), "=&r"(target)); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+BI_LOOP(bi_hinted, "hbr 3f,%1")
+BI_LOOP(bi_unhinted, "lnop")
+
+/*
+ * Hinted loop polling with bisled: falls through while no event is pending,
+ * otherwise branches to a handler that returns with bi to the link register
+ */
+static uint32_t bisled_poll(void)
+{
+    uint32_t n = ITERATIONS, handler, link;
+    uint32_t start = dec_read();
+    __asm__ volatile (
+        "ila %1,5f\n\t"
+        "1: hbrr 3f,1b\n\t" PAD
+        "bisled %2,%1\n\t"
+        "ai %0,%0,-1\n\t"
+        "3: brnz %0,1b\n\t"
+        "br 6f\n\t"
+        "5: bi %2\n\t"
+        "6:\n\t"
+        : "+r"(n), "=&r"(handler), "=&r"(link));
+    return dec_elapsed(start, dec_read());
+}
+
+static uint32_t bisled_no_event(void)
+{
+    spu_write_event_mask(0);
+    return bisled_poll();
+}
+
+/*
+ * Same trick as channel_bench: a tag status update with nothing in flight
+ * leaves the tag event pending until it's acked, so every bisled is taken.
+ * Skipped if the event never shows up
+ */
+static uint32_t bisled_event(void)
+{
+    mfc_write_tag_mask(1 << TAG);
+    spu_write_event_mask(MFC_TAG_STATUS_UPDATE_EVENT);
+    spu_writech(MFC_WrTagUpdate, MFC_TAG_UPDATE_ANY);
+    spu_readch(MFC_RdTagStat);
+    uint32_t ticks = spu_readchcnt(SPU_RdEventStat) ? bisled_poll() : 0;
+    spu_write_event_ack(MFC_TAG_STATUS_UPDATE_EVENT);
+    spu_write_event_mask(0);
+    return ticks;
+}
+
+// Calls through a table of 8 function pointers, bisl with whatever hints spu-gcc adds
+typedef uint32_t (*handler_fn)(uint32_t);
+
+static __attribute__((noinline)) uint32_t handler0(uint32_t x) { return x + 1; }
+static __attribute__((noinline)) uint32_t handler1(uint32_t x) { return x ^ 0x55; }
+static __attribute__((noinline)) uint32_t handler2(uint32_t x) { return x << 1; }
+static __attribute__((noinline)) uint32_t handler3(uint32_t x) { return x - 3; }
+static __attribute__((noinline)) uint32_t handler4(uint32_t x) { return x | 0x100; }
+static __attribute__((noinline)) uint32_t handler5(uint32_t x) { return x >> 1; }
+static __attribute__((noinline)) uint32_t handler6(uint32_t x) { return x * 3; }
+static __attribute__((noinline)) uint32_t handler7(uint32_t x) { return ~x; }
+
+static handler_fn handlers[8] = {
+    handler0, handler1, handler2, handler3, handler4, handler5, handler6, handler7
+};
+
+static volatile uint32_t sink;
+
+// mask 0 always calls handler0, mask 7 cycles through all 8
+static __attribute__((noinline)) uint32_t call_table(uint32_t mask)
+{
+    uint32_t x = 0;
+    // hidden from gcc, or mask 0 can become a direct brsl to handler0
+    __asm__ volatile ("" : "+r"(mask));
+    uint32_t start = dec_read();
+    for (uint32_t i = 0; i < ITERATIONS; ++i)
+        x = handlers[(i * 5) & mask](x);
+    uint32_t ticks = dec_elapsed(start, dec_read());
+    sink = x;
+    return ticks;
+}
+
+static uint32_t fptr_same(void) { return call_table(0); }
+static uint32_t fptr_rotating(void) { return call_table(7); }
+
+// Dense switch, spu-gcc turns it into a jump table and bi
+static __attribute__((noinline)) uint32_t dispatch(uint32_t op, uint32_t x)
+{
+    switch (op) {
+    case 0: return x + 7;
+    case 1: return x ^ 0x1234;
+    case 2: return x << 3;
+    case 3: return x - 11;
+    case 4: return x | 0x8000;
+    case 5: return x >> 2;
+    case 6: return x * 5;
+    default: return ~x;
+    }
+}
+
+static uint32_t switch_table(void)
+{
+    uint32_t x = 0;
+    uint32_t start = dec_read();
+    for (uint32_t i = 0; i < ITERATIONS; ++i)
+        x = dispatch((i * 5) & 7, x);
+    uint32_t ticks = dec_elapsed(start, dec_read());
+    sink = x;
+    return ticks;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(void);
+} branch_test_t;
+
+static const branch_test_t tests[] = {
+    { "brnz loop, hbrr", rel_hinted },
+    { "brnz loop, no hint", rel_unhinted },
+    { "bi loop, hbr", bi_hinted },
+    { "bi loop, no hint", bi_unhinted },
+    { "bisled, no event", bisled_no_event },
+    { "bisled, event", bisled_event },
+    { "fptr same target", fptr_same },
+    { "fptr table of 8", fptr_rotating },
+    { "switch table", switch_table },
+};
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg1;
+    (void)arg3;
+    (void)arg4;
+    uint64_t tbFreq = arg2;
+
+    dec_init();
+
+    spu_printf("spu branch benchmark, %d iterations per kernel\n", ITERATIONS);
+    spu_printf("%-20s %10s %12s\n", "kernel", "cyc/iter", "M iter/s");
+    for (uint32_t i = 0; i < NUM_TESTS; ++i) {
+        uint32_t ticks = tests[i].run();
+        if (ticks == 0) {
+            spu_printf("%-20s %10s\n", tests[i].name, "skipped");
+            continue;
+        }
+        uint32_t cycles = to_hundredths(ticks_to_cycles(ticks, ITERATIONS, tbFreq));
+        uint32_t mips = to_hundredths((double)ITERATIONS * (double)tbFreq / (double)ticks / 1e6);
+        spu_printf("%-20s %7u.%02u %9u.%02u\n", tests[i].name, FIXED2(cycles), FIXED2(mips));
+    }
+
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
@@ -0,0 +1,15 @@
+/*
+ * Shared between channel_bench.spu.c and channel_bench.ppu.c. For the
+ * mailbox and signal reads the SPU DMAs a request word to the PPU, which
+ * then fills the inbound mailbox or writes SNR1
+ */
+#pragma once
+
+#define CHANNEL_BATCHES 2000
+
+// request word: kind << 24 | sequence number
+enum {
+    CHANNEL_REQ_MBOX = 1,   // write 4 values to the inbound mailbox
+    CHANNEL_REQ_SNR1,       // write SNR1 once
+    CHANNEL_REQ_DONE
+};
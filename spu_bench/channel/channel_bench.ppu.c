@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "channel_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_channel_bench_spu_out_start[];
+
+// DMAed here by the SPU, see channel_bench.h
+static volatile uint32_t request __attribute__((aligned(128)));
+// source of the 16 byte GETs in the blocking tag status tests
+static uint32_t dmaSource[32] __attribute__((aligned(128)));
+
+// Answers the SPU's requests until it says it's done
+static int serve(sys_spu_thread_t thread)
+{
+    uint32_t last = 0;
+    for (;;) {
+        uint32_t req;
+        while ((req = request) == last)
+            ;
+        last = req;
+
+        int ret = CELL_OK;
+        switch (req >> 24) {
+        case CHANNEL_REQ_MBOX:
+            for (uint32_t i = 0; i < 4 && ret == CELL_OK; ++i)
+                ret = sys_spu_thread_write_spu_mb(thread, i);
+            break;
+        case CHANNEL_REQ_SNR1:
+            ret = sys_spu_thread_write_snr(thread, 0, 1);
+            break;
+        case CHANNEL_REQ_DONE:
+            return CELL_OK;
+        }
+        if (ret != CELL_OK) {
+            printf("request 0x%08x failed: %x\n", req, ret);
+            return ret;
+        }
+    }
+}
+
+int main(void)
+{
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    request = 0;
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg1 = (uint64_t)(uintptr_t)&request;
+    args.arg2 = sys_time_get_timebase_frequency();
+    args.arg3 = (uint64_t)(uintptr_t)dmaSource;
+
+    spu_bench_group_t g;
+    int ret = spu_bench_start(&g, _binary_channel_bench_spu_out_start, 1, &args);
+    if (ret == CELL_OK) {
+        ret = serve(g.threads[0]);
+        if (ret != CELL_OK)
+            sys_spu_thread_group_terminate(g.group, -1);
+        spu_bench_join(&g, NULL);
+    }
+    spu_bench_finalize();
+    return ret;
+}
@@ -0,0 +1,214 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+#include "channel_bench.h"
+
+#define LOOPS 1024
+#define OPS_PER_RUN (LOOPS * 32)
+#define TAG 0
+
+/*
+ * Channel instructions repeated 32 times in a row. %0 takes rdch/rchcnt
+ * results, %1 is the value written by wrch
+ */
+#define RD(ch) "rdch %0,$ch" #ch "\n\t"
+#define WR(ch) "wrch $ch" #ch ",%1\n\t"
+#define CNT(ch) "rchcnt %0,$ch" #ch "\n\t"
+
+#define CHAN_BENCH(id, insns, value) \
+static uint32_t id(void) \
+{ \
+    qword t, v = si_from_uint(value); \
+    uint32_t start = dec_read(); \
+    for (int i = 0; i < LOOPS; ++i) \
+        __asm__ volatile (".rept 32\n\t" insns ".endr\n\t" : "=r"(t) : "r"(v) : "memory"); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+CHAN_BENCH(rd_dec, RD(8), 0)
+CHAN_BENCH(rd_machstat, RD(13), 0)
+CHAN_BENCH(wr_srr0, WR(14), 0)
+CHAN_BENCH(rd_srr0, RD(15), 0)
+CHAN_BENCH(rd_event_mask, RD(11), 0)
+CHAN_BENCH(wr_event_mask, WR(1), 0)
+CHAN_BENCH(wr_event_ack, WR(2), 0)
+CHAN_BENCH(rd_event_stat, RD(0), 0)
+CHAN_BENCH(cnt_event_stat, CNT(0), 0)
+CHAN_BENCH(wr_tag_mask, WR(22), 1)
+CHAN_BENCH(tag_immediate, WR(23) RD(24), 0)
+CHAN_BENCH(cnt_tag_stat, CNT(24), 0)
+CHAN_BENCH(cnt_out_mbox, CNT(28), 0)
+CHAN_BENCH(cnt_in_mbox, CNT(29), 0)
+CHAN_BENCH(cnt_out_intr_mbox, CNT(30), 0)
+CHAN_BENCH(cnt_snr1, CNT(3), 0)
+
+/*
+ * A tag status update request with nothing in flight completes right away
+ * and raises the tag status event, which stays pending until acked, so
+ * rdch of the event status doesn't block. If the event never shows up the
+ * event status tests are skipped rather than blocking forever
+ */
+static int tagEventWorks;
+
+static uint32_t rd_event_stat_pending(void)
+{
+    mfc_write_tag_mask(1 << TAG);
+    spu_write_event_mask(MFC_TAG_STATUS_UPDATE_EVENT);
+    spu_writech(MFC_WrTagUpdate, MFC_TAG_UPDATE_ANY);
+    spu_readch(MFC_RdTagStat);
+    tagEventWorks = spu_readchcnt(SPU_RdEventStat) != 0;
+    uint32_t ticks = tagEventWorks ? rd_event_stat() : 0;
+    spu_write_event_ack(MFC_TAG_STATUS_UPDATE_EVENT);
+    spu_write_event_mask(0);
+    return ticks;
+}
+
+static qword dmaBuf __attribute__((aligned(16)));
+static uint64_t dmaEa;
+
+// Blocking: a 16 byte GET is in flight every time
+static uint32_t rd_tag_stat_blocking(void)
+{
+    mfc_write_tag_mask(1 << TAG);
+    uint32_t start = dec_read();
+    for (int i = 0; i < OPS_PER_RUN; ++i) {
+        mfc_get(&dmaBuf, dmaEa, 16, TAG, 0, 0);
+        spu_writech(MFC_WrTagUpdate, MFC_TAG_UPDATE_ALL);
+        spu_readch(MFC_RdTagStat);
+    }
+    return dec_elapsed(start, dec_read());
+}
+
+static uint32_t rd_event_stat_blocking(void)
+{
+    if (!tagEventWorks)
+        return 0;
+    mfc_write_tag_mask(1 << TAG);
+    spu_write_event_mask(MFC_TAG_STATUS_UPDATE_EVENT);
+    uint32_t start = dec_read();
+    for (int i = 0; i < OPS_PER_RUN; ++i) {
+        mfc_get(&dmaBuf, dmaEa, 16, TAG, 0, 0);
+        spu_writech(MFC_WrTagUpdate, MFC_TAG_UPDATE_ANY);
+        spu_readch(SPU_RdEventStat);
+        spu_write_event_ack(MFC_TAG_STATUS_UPDATE_EVENT);
+        spu_readch(MFC_RdTagStat);
+    }
+    uint32_t ticks = dec_elapsed(start, dec_read());
+    spu_write_event_mask(0);
+    return ticks;
+}
+
+static volatile uint32_t request[4] __attribute__((aligned(16)));
+static uint64_t requestEa;
+static uint32_t requestSeq;
+
+static void post_request(uint32_t kind)
+{
+    request[0] = (kind << 24) | ++requestSeq;
+    mfc_put(request, requestEa, 4, TAG, 0, 0);
+    mfc_write_tag_mask(1 << TAG);
+    mfc_read_tag_status_all();
+}
+
+/*
+ * Reads with the PPU's help, 4 inbound mailbox entries or one SNR1 value
+ * per batch. Ready: the SPU waits (untimed) until the data is there, so
+ * the timed rdch doesn't block. Blocking: timed from the request, so it
+ * includes the wait for the PPU and the wakeup
+ */
+static uint32_t rd_in_mbox(int blocking)
+{
+    uint32_t ticks = 0;
+    for (int b = 0; b < CHANNEL_BATCHES; ++b) {
+        post_request(CHANNEL_REQ_MBOX);
+        if (!blocking) {
+            while (spu_readchcnt(SPU_RdInMbox) < 4)
+                ;
+        }
+        uint32_t start = dec_read();
+        spu_readch(SPU_RdInMbox);
+        spu_readch(SPU_RdInMbox);
+        spu_readch(SPU_RdInMbox);
+        spu_readch(SPU_RdInMbox);
+        ticks += dec_elapsed(start, dec_read());
+    }
+    return ticks;
+}
+
+static uint32_t rd_snr1(int blocking)
+{
+    uint32_t ticks = 0;
+    for (int b = 0; b < CHANNEL_BATCHES; ++b) {
+        post_request(CHANNEL_REQ_SNR1);
+        if (!blocking) {
+            while (spu_readchcnt(SPU_RdSigNotify1) == 0)
+                ;
+        }
+        uint32_t start = dec_read();
+        spu_readch(SPU_RdSigNotify1);
+        ticks += dec_elapsed(start, dec_read());
+    }
+    return ticks;
+}
+
+static uint32_t rd_in_mbox_ready(void) { return rd_in_mbox(0); }
+static uint32_t rd_in_mbox_blocking(void) { return rd_in_mbox(1); }
+static uint32_t rd_snr1_ready(void) { return rd_snr1(0); }
+static uint32_t rd_snr1_blocking(void) { return rd_snr1(1); }
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(void);
+    uint32_t ops;
+} chan_test_t;
+
+static const chan_test_t tests[] = {
+    { "rdch dec", rd_dec, OPS_PER_RUN },
+    { "rdch machstat", rd_machstat, OPS_PER_RUN },
+    { "wrch srr0", wr_srr0, OPS_PER_RUN },
+    { "rdch srr0", rd_srr0, OPS_PER_RUN },
+    { "rdch evt mask", rd_event_mask, OPS_PER_RUN },
+    { "wrch evt mask", wr_event_mask, OPS_PER_RUN },
+    { "wrch evt ack", wr_event_ack, OPS_PER_RUN },
+    { "rdch evt stat", rd_event_stat_pending, OPS_PER_RUN },
+    { "rchcnt evt stat", cnt_event_stat, OPS_PER_RUN },
+    { "wrch tag mask", wr_tag_mask, OPS_PER_RUN },
+    { "tag immediate", tag_immediate, OPS_PER_RUN },
+    { "rchcnt tag stat", cnt_tag_stat, OPS_PER_RUN },
+    { "rchcnt out mbox", cnt_out_mbox, OPS_PER_RUN },
+    { "rchcnt in mbox", cnt_in_mbox, OPS_PER_RUN },
+    { "rchcnt intr mbox", cnt_out_intr_mbox, OPS_PER_RUN },
+    { "rchcnt snr1", cnt_snr1, OPS_PER_RUN },
+    { "rdch in mbox", rd_in_mbox_ready, CHANNEL_BATCHES * 4 },
+    { "rdch snr1", rd_snr1_ready, CHANNEL_BATCHES },
+    { "B rdch tag stat", rd_tag_stat_blocking, OPS_PER_RUN },
+    { "B rdch evt stat", rd_event_stat_blocking, OPS_PER_RUN },
+    { "B rdch in mbox", rd_in_mbox_blocking, CHANNEL_BATCHES * 4 },
+    { "B rdch snr1", rd_snr1_blocking, CHANNEL_BATCHES },
+};
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg4;
+    requestEa = arg1;
+    uint64_t tbFreq = arg2;
+    dmaEa = arg3;
+
+    dec_init();
+
+    spu_printf("spu channel benchmark, cycles per op at %d MHz, B = blocking\n", (int)(SPU_CLOCK / 1000000));
+    for (uint32_t i = 0; i < NUM_TESTS; ++i) {
+        uint32_t ticks = tests[i].run();
+        uint32_t cycles = to_hundredths(ticks_to_cycles(ticks, tests[i].ops, tbFreq));
+        if (ticks)
+            spu_printf("%-18s %7u.%02u\n", tests[i].name, FIXED2(cycles));
+        else
+            spu_printf("%-18s %10s\n", tests[i].name, "skipped");
+    }
+
+    post_request(CHANNEL_REQ_DONE);
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * PPU side helpers shared by the spu_bench programs: the thread group setup
+ * from spu_test/test_runner.ppu.c, split into start and join so the
+ * benchmark can talk to the SPUs while they run.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/spu_thread_group.h>
+#include <sys/spu_thread.h>
+#include <sys/spu_utility.h>
+#include <sys/spu_image.h>
+#include <sys/spu_initialize.h>
+#include <sys/sys_time.h>
+
+#include <spu_printf.h>
+
+#define SPU_BENCH_MAX_THREADS 6
+
+// Nominal SPU clock, same as in spu_bench_spu.h
+#define SPU_CLOCK 3200000000ULL
+
+typedef struct {
+    sys_spu_thread_group_t group;
+    sys_spu_image_t image;
+    sys_spu_thread_t threads[SPU_BENCH_MAX_THREADS];
+    int numThreads;
+} spu_bench_group_t;
+
+// Once per process, before any group is created
+static inline int spu_bench_init(void)
+{
+    int ret = sys_spu_initialize(SPU_BENCH_MAX_THREADS, 0);
+    if (ret != CELL_OK) {
+        printf("sys_spu_initialize failed: %d\n", ret);
+        return ret;
+    }
+    ret = spu_printf_initialize(1000, NULL);
+    if (ret != CELL_OK)
+        printf("spu_printf_initialize failed %x\n", ret);
+    return ret;
+}
+
+static inline void spu_bench_finalize(void)
+{
+    spu_printf_finalize();
+}
+
+/*
+ * Creates a group of numThreads threads all running elf, thread i gets
+ * args[i], and starts it. Everything created is torn down again on failure
+ */
+static inline int spu_bench_start(spu_bench_group_t *g, const void *elf, int numThreads,
+                                  const sys_spu_thread_argument_t *args)
+{
+    int ret;
+    sys_spu_thread_group_attribute_t grp_attr;
+
+    g->numThreads = numThreads;
+    sys_spu_thread_group_attribute_initialize(grp_attr);
+    sys_spu_thread_group_attribute_name(grp_attr, "spu bench grp");
+    ret = sys_spu_thread_group_create(&g->group, numThreads, 100, &grp_attr);
+    if (ret != CELL_OK) {
+        printf("spu_thread_group_create failed: %d\n", ret);
+        return ret;
+    }
+
+    ret = sys_spu_image_import(&g->image, elf, SYS_SPU_IMAGE_DIRECT);
+    if (ret != CELL_OK) {
+        printf("sys_spu_image_import: %d\n", ret);
+        sys_spu_thread_group_destroy(g->group);
+        return ret;
+    }
+
+    for (int i = 0; i < numThreads; ++i) {
+        sys_spu_thread_attribute_t thr_attr;
+        sys_spu_thread_argument_t thr_args = args[i];
+        sys_spu_thread_attribute_initialize(thr_attr);
+        sys_spu_thread_attribute_name(thr_attr, "spu bench thread");
+        ret = sys_spu_thread_initialize(&g->threads[i], g->group, i, &g->image, &thr_attr, &thr_args);
+        if (ret != CELL_OK) {
+            printf("sys_spu_thread_initialize: %d\n", ret);
+            goto fail;
+        }
+    }
+
+    ret = spu_printf_attach_group(g->group);
+    if (ret != CELL_OK) {
+        printf("spu_printf_attach_group failed %x\n", ret);
+        goto fail;
+    }
+
+    ret = sys_spu_thread_group_start(g->group);
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_start: %d\n", ret);
+        spu_printf_detach_group(g->group);
+        goto fail;
+    }
+    return CELL_OK;
+
+fail:
+    sys_spu_thread_group_destroy(g->group);
+    sys_spu_image_close(&g->image);
+    return ret;
+}
+
+// Waits for the group to exit and destroys it, exit statuses go to status
+static inline int spu_bench_join(spu_bench_group_t *g, int *status)
+{
+    int cause, groupStatus;
+    int ret = sys_spu_thread_group_join(g->group, &cause, &groupStatus);
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_join: %d\n", ret);
+        return ret;
+    }
+
+    if (status != NULL) {
+        for (int i = 0; i < g->numThreads; ++i)
+            sys_spu_thread_get_exit_status(g->threads[i], &status[i]);
+    }
+
+    spu_printf_detach_group(g->group);
+    ret = sys_spu_thread_group_destroy(g->group);
+    if (ret != CELL_OK)
+        printf("sys_spu_thread_group_destroy: %d\n", ret);
+    sys_spu_image_close(&g->image);
+    return ret;
+}
+
+// Runs a single thread group to completion, for the benchmarks that only
+// need arguments in and results out
+static inline int spu_bench_run(const void *elf, int numThreads, const sys_spu_thread_argument_t *args)
+{
+    spu_bench_group_t g;
+    int ret = spu_bench_start(&g, elf, numThreads, args);
+    if (ret != CELL_OK)
+        return ret;
+    return spu_bench_join(&g, NULL);
+}
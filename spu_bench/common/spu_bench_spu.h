@@ -0,0 +1,78 @@
+/*
+ * SPU side helpers shared by the spu_bench programs: decrementer timing,
+ * blocking DMA and number formatting for spu_printf.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <sys/spu_thread.h>
+#include <spu_printf.h>
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+// Nominal SPU clock, used to turn decrementer ticks into cycles
+#define SPU_CLOCK 3200000000ULL
+
+// Tag reserved for the helpers below, benchmarks use 0..30
+#define SPU_BENCH_TAG 31
+
+// The decrementer counts down at the timebase frequency, start it from the
+// top once so a run never sees it wrap
+static inline void dec_init(void)
+{
+    spu_write_decrementer(0xFFFFFFFF);
+}
+
+static inline uint32_t dec_read(void)
+{
+    return spu_read_decrementer();
+}
+
+// Ticks between two dec_read() calls
+static inline uint32_t dec_elapsed(uint32_t start, uint32_t end)
+{
+    return start - end;
+}
+
+// Blocking transfers of any multiple of 16 bytes, split into 16KB commands
+static inline void dma_get_wait(volatile void *ls, uint64_t ea, uint32_t size)
+{
+    for (uint32_t done = 0; done < size; done += 16384) {
+        uint32_t chunk = size - done > 16384 ? 16384 : size - done;
+        mfc_get((volatile uint8_t *)ls + done, ea + done, chunk, SPU_BENCH_TAG, 0, 0);
+    }
+    mfc_write_tag_mask(1 << SPU_BENCH_TAG);
+    mfc_read_tag_status_all();
+}
+
+static inline void dma_put_wait(volatile void *ls, uint64_t ea, uint32_t size)
+{
+    for (uint32_t done = 0; done < size; done += 16384) {
+        uint32_t chunk = size - done > 16384 ? 16384 : size - done;
+        mfc_put((volatile uint8_t *)ls + done, ea + done, chunk, SPU_BENCH_TAG, 0, 0);
+    }
+    mfc_write_tag_mask(1 << SPU_BENCH_TAG);
+    mfc_read_tag_status_all();
+}
+
+/*
+ * Values are printed as fixed point with 2 decimals (hundredths), so the
+ * output doesn't depend on spu_printf's float support
+ */
+static inline uint32_t to_hundredths(double v)
+{
+    return v <= 0.0 ? 0 : (uint32_t)(v * 100.0 + 0.5);
+}
+
+#define FIXED2(h) (h) / 100, (h) % 100
+
+// Cycles per operation for count operations that took ticks
+static inline double ticks_to_cycles(uint32_t ticks, uint64_t count, uint64_t tbFreq)
+{
+    return (double)ticks * ((double)SPU_CLOCK / (double)tbFreq) / (double)count;
+}
+
+static inline double ticks_to_ns(uint32_t ticks, uint64_t count, uint64_t tbFreq)
+{
+    return (double)ticks * 1e9 / (double)tbFreq / (double)count;
+}
@@ -0,0 +1,10 @@
+/*
+ * Buffer layout shared by dma_bench.spu.c and dma_bench.ppu.c. GETs read
+ * from the source buffer, word i of it holds i. PUTs write the destination
+ * buffer from an LS buffer holding ~i in word i, so afterwards destination
+ * word i holds ~(i % (DMA_BENCH_LS_SIZE / 4))
+ */
+#pragma once
+
+#define DMA_BENCH_EA_SIZE 0x100000
+#define DMA_BENCH_LS_SIZE 0x8000
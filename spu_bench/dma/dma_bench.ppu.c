@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "dma_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_dma_bench_spu_out_start[];
+
+int main(void)
+{
+    uint32_t *src = memalign(128, DMA_BENCH_EA_SIZE);
+    uint32_t *dst = memalign(128, DMA_BENCH_EA_SIZE);
+    if (src == NULL || dst == NULL) {
+        printf("couldn't allocate dma buffers\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < DMA_BENCH_EA_SIZE / 4; ++i)
+        src[i] = i;
+    memset(dst, 0, DMA_BENCH_EA_SIZE);
+
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg1 = (uint64_t)(uintptr_t)src;
+    args.arg2 = sys_time_get_timebase_frequency();
+    args.arg3 = (uint64_t)(uintptr_t)dst;
+
+    spu_bench_group_t g;
+    int status = 0;
+    int ret = spu_bench_start(&g, _binary_dma_bench_spu_out_start, 1, &args);
+    if (ret == CELL_OK)
+        ret = spu_bench_join(&g, &status);
+    spu_bench_finalize();
+    if (ret != CELL_OK)
+        return ret;
+
+    uint32_t putErrors = 0;
+    for (uint32_t i = 0; i < DMA_BENCH_EA_SIZE / 4; ++i) {
+        if (dst[i] != ~(i % (DMA_BENCH_LS_SIZE / 4)))
+            ++putErrors;
+    }
+
+    printf("get: %d words wrong, put: %u words wrong\n", status, putErrors);
+    free(src);
+    free(dst);
+    return (status || putErrors) ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+#include "dma_bench.h"
+
+// Every throughput run moves the whole EA buffer, LS wraps every 32KB
+#define TOTAL DMA_BENCH_EA_SIZE
+#define LS_MASK (DMA_BENCH_LS_SIZE - 1)
+#define LAT_REPS 256
+#define TAG 0
+
+static uint8_t ls[DMA_BENCH_LS_SIZE] __attribute__((aligned(128)));
+static mfc_list_element_t list[2048] __attribute__((aligned(8)));
+
+/*
+ * Back to back commands on one tag, the MFC_Cmd channel write stalls when
+ * the queue is full, so this keeps the queue full and waits once at the end.
+ * The f/b forms are ordered against everything queued before them on the tag
+ */
+#define DMA_STREAM(name, cmd) \
+static uint32_t name(uint64_t ea, uint32_t size) \
+{ \
+    mfc_write_tag_mask(1 << TAG); \
+    uint32_t start = dec_read(); \
+    for (uint32_t off = 0; off < TOTAL; off += size) \
+        cmd(ls + (off & LS_MASK), ea + off, size, TAG, 0, 0); \
+    mfc_read_tag_status_all(); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+DMA_STREAM(get, mfc_get)
+DMA_STREAM(getf, mfc_getf)
+DMA_STREAM(getb, mfc_getb)
+DMA_STREAM(put, mfc_put)
+DMA_STREAM(putf, mfc_putf)
+DMA_STREAM(putb, mfc_putb)
+
+/*
+ * One list fills all of ls, element i gathers from (scatters to) offset
+ * i * 32 * size so a list touches the whole EA buffer. It's built once per
+ * size and issued TOTAL / DMA_BENCH_LS_SIZE times
+ */
+static uint32_t list_build(uint64_t ea, uint32_t size)
+{
+    uint32_t n = DMA_BENCH_LS_SIZE / size;
+    uint32_t stride = TOTAL / n;
+    for (uint32_t i = 0; i < n; ++i) {
+        list[i].notify = 0;
+        list[i].reserved = 0;
+        list[i].size = size;
+        list[i].eal = (uint32_t)ea + i * stride;
+    }
+    return n;
+}
+
+#define DMA_LIST(name, cmd) \
+static uint32_t name(uint64_t ea, uint32_t size) \
+{ \
+    uint32_t n = list_build(ea, size); \
+    mfc_write_tag_mask(1 << TAG); \
+    uint32_t start = dec_read(); \
+    for (uint32_t off = 0; off < TOTAL; off += DMA_BENCH_LS_SIZE) \
+        cmd(ls, ea, list, n * sizeof(mfc_list_element_t), TAG, 0, 0); \
+    mfc_read_tag_status_all(); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+DMA_LIST(getl, mfc_getl)
+DMA_LIST(putl, mfc_putl)
+
+// Issue to tag completion, one command in flight at a time
+#define DMA_LATENCY(name, cmd) \
+static uint32_t name(uint64_t ea, uint32_t size) \
+{ \
+    mfc_write_tag_mask(1 << TAG); \
+    uint32_t start = dec_read(); \
+    for (uint32_t i = 0; i < LAT_REPS; ++i) { \
+        uint32_t off = (i * size) & (TOTAL - 1); \
+        cmd(ls + (off & LS_MASK), ea + off, size, TAG, 0, 0); \
+        mfc_read_tag_status_all(); \
+    } \
+    return dec_elapsed(start, dec_read()); \
+}
+
+DMA_LATENCY(get_latency, mfc_get)
+DMA_LATENCY(put_latency, mfc_put)
+
+/*
+ * After a streamed getf/getb ls holds the last 32KB of the source, after a
+ * list GET element i holds source offset i * 32 * size. Plain GETs to the
+ * same LS bytes may complete in any order, so get isn't checked. Returns
+ * wrong words
+ */
+static uint32_t check_get(int isList, uint32_t size)
+{
+    const uint32_t *w = (const uint32_t *)ls;
+    uint32_t errors = 0;
+    for (uint32_t o = 0; o < DMA_BENCH_LS_SIZE; o += 4) {
+        uint32_t src = isList ? (o / size) * (TOTAL / (DMA_BENCH_LS_SIZE / size)) + o % size
+                              : TOTAL - DMA_BENCH_LS_SIZE + o;
+        if (w[o / 4] != src / 4)
+            ++errors;
+    }
+    return errors;
+}
+
+static void fill_put_pattern(void)
+{
+    uint32_t *w = (uint32_t *)ls;
+    for (uint32_t i = 0; i < DMA_BENCH_LS_SIZE / 4; ++i)
+        w[i] = ~i;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(uint64_t, uint32_t);
+    int isPut;
+    int isList;
+    int checkGet;       // LS contents are defined after the run
+} dma_test_t;
+
+// putl goes before the streamed PUTs, they rewrite all of the destination
+// in the layout the PPU checks
+static const dma_test_t tests[] = {
+    { "get", get, 0, 0, 0 }, { "getf", getf, 0, 0, 1 }, { "getb", getb, 0, 0, 1 }, { "getl", getl, 0, 1, 1 },
+    { "putl", putl, 1, 1, 0 }, { "put", put, 1, 0, 0 }, { "putf", putf, 1, 0, 0 }, { "putb", putb, 1, 0, 0 },
+};
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg4;
+    uint64_t srcEa = arg1;
+    uint64_t tbFreq = arg2;
+    uint64_t dstEa = arg3;
+    uint32_t errors = 0;
+
+    dec_init();
+
+    spu_printf("spu dma benchmark, %d KB per run, GB/s and ns per command\n", TOTAL / 1024);
+    spu_printf("%6s", "size");
+    for (uint32_t t = 0; t < NUM_TESTS; ++t)
+        spu_printf(" %7s", tests[t].name);
+    spu_printf(" %7s %7s\n", "get ns", "put ns");
+
+    for (uint32_t size = 16; size <= 16384; size *= 2) {
+        spu_printf("%6u", size);
+        for (uint32_t t = 0; t < NUM_TESTS; ++t) {
+            const dma_test_t *test = &tests[t];
+            if (test->isPut)
+                fill_put_pattern();
+            uint32_t ticks = test->run(test->isPut ? dstEa : srcEa, size);
+            uint32_t gbs = to_hundredths((double)TOTAL * (double)tbFreq / (double)ticks / 1e9);
+            spu_printf(" %4u.%02u", FIXED2(gbs));
+            if (test->checkGet)
+                errors += check_get(test->isList, size);
+        }
+
+        uint32_t getNs = (uint32_t)ticks_to_ns(get_latency(srcEa, size), LAT_REPS, tbFreq);
+        fill_put_pattern();
+        uint32_t putNs = (uint32_t)ticks_to_ns(put_latency(dstEa, size), LAT_REPS, tbFreq);
+        spu_printf(" %7u %7u\n", getNs, putNs);
+    }
+
+    if (errors)
+        spu_printf("%u words wrong after GET\n", errors);
+    spu_printf("done!\n");
+    sys_spu_thread_exit(errors);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+
+/*
+ * Issue rate of the SP and DP arithmetic ops on each class of input. Every
+ * instruction reads the same fixed operands (b, c, d) into one of 8
+ * registers, so there is no dependency between them and the input class
+ * stays the same for the whole run. dfma has no separate addend and
+ * accumulates into its target: that stays in class for normal, NaN and
+ * infinity, but on the denormal row one step of 2^-1023 reaches the minimum
+ * normal, so only the b operand stays denormal
+ */
+#define LOOPS 4096
+#define INSNS_PER_RUN (LOOPS * 32)
+
+typedef struct {
+    qword seed;     // start value of the 8 targets
+    qword b, c, d;
+} fp_in_t;
+
+#define OP2(op, k) op " %" #k ",%8,%9\n\t"          // rt = b op c, dfma: rt = b * c + rt
+#define OP3(op, k) op " %" #k ",%8,%9,%10\n\t"      // rt = b * c + d
+
+#define CHAIN8(FORM, op) \
+    FORM(op, 0) FORM(op, 1) FORM(op, 2) FORM(op, 3) \
+    FORM(op, 4) FORM(op, 5) FORM(op, 6) FORM(op, 7)
+
+#define BENCH(id, FORM, op) \
+static uint32_t id##_run(const fp_in_t *in) \
+{ \
+    qword r0 = in->seed, r1 = in->seed, r2 = in->seed, r3 = in->seed; \
+    qword r4 = in->seed, r5 = in->seed, r6 = in->seed, r7 = in->seed; \
+    qword b = in->b, c = in->c, d = in->d; \
+    uint32_t start = dec_read(); \
+    for (int i = 0; i < LOOPS; ++i) \
+        __asm__ volatile (".rept 4\n\t" CHAIN8(FORM, op) ".endr\n\t" \
+            : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3), "+r"(r4), "+r"(r5), "+r"(r6), "+r"(r7) \
+            : "r"(b), "r"(c), "r"(d)); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+BENCH(fa, OP2, "fa")
+BENCH(fm, OP2, "fm")
+BENCH(fma, OP3, "fma")
+BENCH(dfa, OP2, "dfa")
+BENCH(dfm, OP2, "dfm")
+BENCH(dfma, OP2, "dfma")
+
+enum { C_NORMAL, C_DENORMAL, C_NAN, C_EXTENDED, C_COUNT };
+
+static const char *classNames[C_COUNT] = { "normal", "denormal", "nan", "ext/inf" };
+
+/*
+ * SP: the SPU has no denormals (read as 0) and no NaN or infinity, exponent
+ * 255 is just the extended range, so the nan and ext rows are xfloat values
+ * an IEEE host sees as NaN and infinity. DP is IEEE, ext/inf is infinity
+ */
+static const uint32_t spClass[C_COUNT] = { 0x3FC00000, 0x00400000, 0x7FC00000, 0x7F800000 };
+static const uint64_t dpClass[C_COUNT] = {
+    0x3FF8000000000000ULL, 0x0008000000000000ULL, 0x7FF8000000000000ULL, 0x7FF0000000000000ULL
+};
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(const fp_in_t *);
+    int isDouble;
+} fp_op_t;
+
+static const fp_op_t ops[] = {
+    { "fa", fa_run, 0 }, { "fm", fm_run, 0 }, { "fma", fma_run, 0 },
+    { "dfa", dfa_run, 1 }, { "dfm", dfm_run, 1 }, { "dfma", dfma_run, 1 },
+};
+#define NUM_OPS (sizeof(ops) / sizeof(ops[0]))
+
+static void make_input(fp_in_t *in, int isDouble, int cls)
+{
+    qword v, one;
+    if (isDouble) {
+        v = (qword)spu_splats(dpClass[cls]);
+        one = (qword)spu_splats(0x3FF0000000000000ULL);
+    }
+    else {
+        v = (qword)spu_splats(spClass[cls]);
+        one = (qword)spu_splats(0x3F800000u);
+    }
+    in->seed = v;
+    in->b = v;
+    in->c = one;
+    in->d = v;
+}
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg1;
+    (void)arg3;
+    (void)arg4;
+    uint64_t tbFreq = arg2;
+
+    dec_init();
+
+    spu_printf("spu fp throughput by input class, %d instructions per run, cycles per instruction at %d MHz\n",
+               INSNS_PER_RUN, (int)(SPU_CLOCK / 1000000));
+    spu_printf("%-6s", "op");
+    for (int cls = 0; cls < C_COUNT; ++cls)
+        spu_printf(" %9s", classNames[cls]);
+    spu_printf("\n");
+
+    for (uint32_t i = 0; i < NUM_OPS; ++i) {
+        spu_printf("%-6s", ops[i].name);
+        for (int cls = 0; cls < C_COUNT; ++cls) {
+            fp_in_t in;
+            make_input(&in, ops[i].isDouble, cls);
+            uint32_t cycles = to_hundredths(ticks_to_cycles(ops[i].run(&in), INSNS_PER_RUN, tbFreq));
+            spu_printf(" %6u.%02u", FIXED2(cycles));
+        }
+        spu_printf("\n");
+    }
+
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
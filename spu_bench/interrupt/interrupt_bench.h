@@ -0,0 +1,15 @@
+/*
+ * Shared between interrupt_bench.spu.c and interrupt_bench.ppu.c. The SPU
+ * runs as a raw SPU and raises class 2 mailbox interrupts by writing its
+ * outbound interrupt mailbox, the PPU interrupt thread reads and acks them
+ */
+#pragma once
+
+#define INTR_ROUNDS 10000
+
+// Set in the mailbox value when the SPU waits for an answer on its inbound
+// mailbox, the low bits count the interrupts of each phase
+#define INTR_PING 0x80000000
+
+// stop code once the results are in the outbound mailbox
+#define INTR_STOP_DONE 0x3000
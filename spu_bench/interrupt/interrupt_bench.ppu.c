@@ -0,0 +1,188 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/interrupt.h>
+#include <sys/ppu_thread.h>
+#include <sys/raw_spu.h>
+#include <sys/spu_image.h>
+#include <sys/spu_initialize.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+#include "interrupt_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/*
+ * Raw SPU interrupt benchmark, the setup from raw_spu_test/stack_addr: a
+ * class 2 interrupt tag on the raw SPU, an interrupt PPU thread established
+ * on it that handles the mailbox interrupt and calls
+ * sys_interrupt_thread_eoi. Loading and running the SPU is done the way
+ * spu_test/raw_runner.ppu.c does it
+ */
+
+/* embedded SPU ELF symbols */
+extern char _binary_interrupt_bench_spu_out_start[];
+
+#define INTR_CLASS 2
+#define INTR_PPU_MB_MASK 0x1        // class 2: outbound interrupt mailbox written
+
+// problem state registers
+#define SPU_OUT_MBOX_OFFS 0x04004
+#define SPU_IN_MBOX_OFFS 0x0400C
+#define SPU_MBOX_STATUS_OFFS 0x04014
+#define SPU_RUNCNTL_OFFS 0x0401C
+#define SPU_STATUS_OFFS 0x04024
+
+#define SPU_STATUS_RUNNING 0x1
+#define SPU_STATUS_STOPPED_BY_STOP 0x2
+#define SPU_STOP_STATUS_SHIFT 16
+
+static sys_raw_spu_t spu;
+
+// written by the interrupt thread only
+static volatile uint32_t received;
+static volatile uint32_t outOfOrder;
+static volatile uint64_t handlerTicks;
+static uint32_t expected;
+
+static void intr_handler(uint64_t arg)
+{
+    (void)arg;
+    uint64_t start = __mftb();
+    uint64_t stat;
+
+    if (sys_raw_spu_get_int_stat(spu, INTR_CLASS, &stat) == CELL_OK && (stat & INTR_PPU_MB_MASK)) {
+        // clear before reading, once the mailbox is read the SPU can write
+        // the next value and that has to raise a new interrupt
+        sys_raw_spu_set_int_stat(spu, INTR_CLASS, INTR_PPU_MB_MASK);
+        uint32_t mb;
+        sys_raw_spu_read_puint_mb(spu, &mb);
+        if (mb & INTR_PING)
+            sys_raw_spu_mmio_write(spu, SPU_IN_MBOX_OFFS, mb);
+
+        // the count restarts at 0 for the streamed phase
+        uint32_t count = mb & ~INTR_PING;
+        if (count == 0)
+            expected = 0;
+        if (count != expected)
+            outOfOrder = outOfOrder + 1;
+        expected = count + 1;
+        received = received + 1;
+    }
+
+    handlerTicks = handlerTicks + (__mftb() - start);
+    sys_interrupt_thread_eoi();
+}
+
+// Waits for the SPU's next outbound mailbox value, 0 if it doesn't come
+// before deadline (timebase)
+static int read_out_mbox(uint32_t *value, uint64_t deadline)
+{
+    while ((sys_raw_spu_mmio_read(spu, SPU_MBOX_STATUS_OFFS) & 0xFF) == 0) {
+        if (__mftb() > deadline)
+            return 0;
+    }
+    *value = sys_raw_spu_mmio_read(spu, SPU_OUT_MBOX_OFFS);
+    return 1;
+}
+
+int main(void)
+{
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+    sys_interrupt_tag_t intrTag;
+    sys_ppu_thread_t handler;
+    sys_interrupt_thread_handle_t ih;
+    sys_spu_image_t img;
+
+    int ret = sys_spu_initialize(1, 1);
+    if (ret != CELL_OK) {
+        printf("sys_spu_initialize failed: %d\n", ret);
+        return ret;
+    }
+
+    ret = sys_raw_spu_create(&spu, NULL);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_create failed: %d\n", ret);
+        return ret;
+    }
+
+    ret = sys_spu_image_import(&img, (void*)_binary_interrupt_bench_spu_out_start, SYS_SPU_IMAGE_DIRECT);
+    if (ret != CELL_OK) {
+        printf("sys_spu_image_import: %d\n", ret);
+        goto destroy;
+    }
+    ret = sys_raw_spu_image_load(spu, &img);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_image_load: %d\n", ret);
+        goto close;
+    }
+
+    ret = sys_raw_spu_create_interrupt_tag(spu, INTR_CLASS, SYS_HW_THREAD_ANY, &intrTag);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_create_interrupt_tag failed: %x\n", ret);
+        goto close;
+    }
+    ret = sys_ppu_thread_create(&handler, intr_handler, 0, 100, 0x4000, SYS_PPU_THREAD_CREATE_INTERRUPT, "Interrupt Thread");
+    if (ret != CELL_OK) {
+        printf("sys_ppu_thread_create failed: %x\n", ret);
+        goto tag;
+    }
+    ret = sys_interrupt_thread_establish(&ih, intrTag, handler, 0);
+    if (ret != CELL_OK) {
+        printf("sys_interrupt_thread_establish failed: %x\n", ret);
+        goto tag;
+    }
+    ret = sys_raw_spu_set_int_mask(spu, INTR_CLASS, INTR_PPU_MB_MASK);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_set_int_mask failed: %x\n", ret);
+        goto disestablish;
+    }
+
+    printf("raw spu interrupt benchmark, %d interrupts per phase\n", INTR_ROUNDS);
+
+    // a lost interrupt leaves the SPU waiting forever, give up after 10s
+    uint64_t start = __mftb();
+    uint64_t deadline = start + 10 * tbFreq;
+    uint32_t pingTicks, streamTicks;
+    sys_raw_spu_mmio_write(spu, SPU_RUNCNTL_OFFS, 1);
+    if (!read_out_mbox(&pingTicks, deadline) || !read_out_mbox(&streamTicks, deadline)) {
+        printf("timed out after %u interrupts\n", received);
+        sys_raw_spu_mmio_write(spu, SPU_RUNCNTL_OFFS, 0);
+        ret = -1;
+        goto disestablish;
+    }
+    while (received != 2 * INTR_ROUNDS)
+        ;
+    uint64_t wallTicks = __mftb() - start;
+
+    uint32_t status;
+    while ((status = sys_raw_spu_mmio_read(spu, SPU_STATUS_OFFS)) & SPU_STATUS_RUNNING)
+        ;
+    if (!(status & SPU_STATUS_STOPPED_BY_STOP) || (status >> SPU_STOP_STATUS_SHIFT) != INTR_STOP_DONE)
+        printf("unexpected SPU status 0x%08x\n", status);
+
+    // the SPU decrementer runs at the timebase frequency
+    double rtUs = (double)pingTicks * 1e6 / (double)tbFreq / INTR_ROUNDS;
+    double handlerUs = (double)handlerTicks * 1e6 / (double)tbFreq / (2 * INTR_ROUNDS);
+    printf("round trip (interrupt, handler, inbound mailbox): %.2f us, %.0f per second\n",
+           rtUs, INTR_ROUNDS * (double)tbFreq / (double)pingTicks);
+    printf("streamed: %.2f us per interrupt, %.0f interrupts per second\n",
+           (double)streamTicks * 1e6 / (double)tbFreq / INTR_ROUNDS, INTR_ROUNDS * (double)tbFreq / (double)streamTicks);
+    printf("time in handler: %.2f us, round trip minus handler: %.2f us\n", handlerUs, rtUs - handlerUs);
+    printf("total %.2f ms, %u interrupts handled, %u out of order\n",
+           (double)wallTicks * 1e3 / (double)tbFreq, received, outOfOrder);
+    ret = outOfOrder ? 1 : 0;
+
+disestablish:
+    sys_interrupt_thread_disestablish(ih);
+tag:
+    sys_interrupt_tag_destroy(intrTag);
+close:
+    sys_spu_image_close(&img);
+destroy:
+    sys_raw_spu_destroy(spu);
+    return ret;
+}
@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+#include "interrupt_bench.h"
+
+/*
+ * Runs on a raw SPU, so no lv2 SPU thread services: the timings go back
+ * through the outbound mailbox and the SPU stops when it is done
+ */
+int main(void)
+{
+    spu_write_decrementer(0xFFFFFFFF);
+
+    // round trips, the interrupt handler answers each one on the inbound
+    // mailbox
+    uint32_t start = spu_read_decrementer();
+    for (uint32_t i = 0; i < INTR_ROUNDS; ++i) {
+        spu_write_out_intr_mbox(INTR_PING | i);
+        spu_read_in_mbox();
+    }
+    uint32_t pingTicks = start - spu_read_decrementer();
+
+    // back to back, the write stalls until the handler has read the
+    // previous value, so this runs at the rate interrupts get handled
+    start = spu_read_decrementer();
+    for (uint32_t i = 0; i < INTR_ROUNDS; ++i)
+        spu_write_out_intr_mbox(i);
+    uint32_t streamTicks = start - spu_read_decrementer();
+
+    spu_write_out_mbox(pingTicks);
+    spu_write_out_mbox(streamTicks);
+    spu_stop(INTR_STOP_DONE);
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ppu_intrinsics.h>
+#include <sys/process.h>
+#include <sys/spu_thread_group.h>
+#include <sys/spu_thread.h>
+#include <sys/spu_image.h>
+#include <sys/spu_initialize.h>
+#include <sys/sys_time.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_lifecycle_small_spu_out_start[];
+extern char _binary_lifecycle_64k_spu_out_start[];
+extern char _binary_lifecycle_160k_spu_out_start[];
+
+#define ITERATIONS 100
+#define MAX_THREADS 6
+
+typedef struct {
+    const char *name;
+    const void *elf;
+} image_t;
+
+static const image_t images[] = {
+    { "small", _binary_lifecycle_small_spu_out_start },
+    { "64KB", _binary_lifecycle_64k_spu_out_start },
+    { "160KB", _binary_lifecycle_160k_spu_out_start },
+};
+#define NUM_IMAGES (sizeof(images) / sizeof(images[0]))
+
+// the steps of test_runner.ppu.c, in order
+enum {
+    PHASE_CREATE,
+    PHASE_IMPORT,
+    PHASE_INIT,
+    PHASE_START,
+    PHASE_JOIN,
+    PHASE_DESTROY,
+    PHASE_CLOSE,
+    PHASE_COUNT
+};
+
+static const char *phaseNames[PHASE_COUNT] = { "create", "import", "thr init", "start", "join", "destroy", "close" };
+
+/*
+ * One full lifecycle, adds each phase's timebase ticks to ticks. Whatever
+ * was created is torn down again on failure
+ */
+static int lifecycle(const void *elf, uint32_t importType, int numThreads, uint64_t *ticks)
+{
+    sys_spu_thread_group_t group;
+    sys_spu_thread_group_attribute_t grp_attr;
+    sys_spu_image_t img;
+    sys_spu_thread_t threads[MAX_THREADS];
+    sys_spu_thread_argument_t args;
+    int cause, status, ret;
+
+    memset(&args, 0, sizeof(args));
+    sys_spu_thread_group_attribute_initialize(grp_attr);
+    sys_spu_thread_group_attribute_name(grp_attr, "lifecycle grp");
+
+    uint64_t t0 = __mftb();
+    ret = sys_spu_thread_group_create(&group, numThreads, 100, &grp_attr);
+    uint64_t t1 = __mftb();
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_create: %d\n", ret);
+        return ret;
+    }
+    ticks[PHASE_CREATE] += t1 - t0;
+
+    t0 = __mftb();
+    ret = sys_spu_image_import(&img, elf, importType);
+    t1 = __mftb();
+    if (ret != CELL_OK) {
+        printf("sys_spu_image_import: %d\n", ret);
+        sys_spu_thread_group_destroy(group);
+        return ret;
+    }
+    ticks[PHASE_IMPORT] += t1 - t0;
+
+    t0 = __mftb();
+    for (int i = 0; i < numThreads; ++i) {
+        sys_spu_thread_attribute_t thr_attr;
+        sys_spu_thread_attribute_initialize(thr_attr);
+        sys_spu_thread_attribute_name(thr_attr, "lifecycle thread");
+        ret = sys_spu_thread_initialize(&threads[i], group, i, &img, &thr_attr, &args);
+        if (ret != CELL_OK) {
+            printf("sys_spu_thread_initialize: %d\n", ret);
+            goto fail;
+        }
+    }
+    t1 = __mftb();
+    ticks[PHASE_INIT] += t1 - t0;
+
+    t0 = __mftb();
+    ret = sys_spu_thread_group_start(group);
+    t1 = __mftb();
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_start: %d\n", ret);
+        goto fail;
+    }
+    ticks[PHASE_START] += t1 - t0;
+
+    // the threads exit right away, this is mostly the time to notice
+    t0 = __mftb();
+    ret = sys_spu_thread_group_join(group, &cause, &status);
+    t1 = __mftb();
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_join: %d\n", ret);
+        return ret;
+    }
+    ticks[PHASE_JOIN] += t1 - t0;
+
+    t0 = __mftb();
+    ret = sys_spu_thread_group_destroy(group);
+    t1 = __mftb();
+    if (ret != CELL_OK) {
+        printf("sys_spu_thread_group_destroy: %d\n", ret);
+        sys_spu_image_close(&img);
+        return ret;
+    }
+    ticks[PHASE_DESTROY] += t1 - t0;
+
+    t0 = __mftb();
+    ret = sys_spu_image_close(&img);
+    t1 = __mftb();
+    if (ret != CELL_OK)
+        printf("sys_spu_image_close: %d\n", ret);
+    ticks[PHASE_CLOSE] += t1 - t0;
+    return ret;
+
+fail:
+    sys_spu_thread_group_destroy(group);
+    sys_spu_image_close(&img);
+    return ret;
+}
+
+static int run(const image_t *image, uint32_t importType, int numThreads, uint64_t tbFreq)
+{
+    uint64_t ticks[PHASE_COUNT];
+    memset(ticks, 0, sizeof(ticks));
+
+    for (int i = 0; i < ITERATIONS; ++i) {
+        int ret = lifecycle(image->elf, importType, numThreads, ticks);
+        if (ret != CELL_OK)
+            return ret;
+    }
+
+    uint64_t total = 0;
+    printf("%-6s %-7s %d", image->name, importType == SYS_SPU_IMAGE_DIRECT ? "direct" : "protect", numThreads);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        printf(" %9.1f", (double)ticks[p] * 1e6 / (double)tbFreq / ITERATIONS);
+        total += ticks[p];
+    }
+    printf(" %9.1f\n", (double)total * 1e6 / (double)tbFreq / ITERATIONS);
+    return CELL_OK;
+}
+
+int main(void)
+{
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+
+    // only allowed once per process
+    uint64_t start = __mftb();
+    int ret = sys_spu_initialize(MAX_THREADS, 0);
+    uint64_t ticks = __mftb() - start;
+    if (ret != CELL_OK) {
+        printf("sys_spu_initialize failed: %d\n", ret);
+        return ret;
+    }
+
+    printf("spu thread group lifecycle, %d iterations, us per phase\n", ITERATIONS);
+    printf("sys_spu_initialize: %.1f us\n", (double)ticks * 1e6 / (double)tbFreq);
+    printf("%-6s %-7s %s", "image", "import", "n");
+    for (int p = 0; p < PHASE_COUNT; ++p)
+        printf(" %9s", phaseNames[p]);
+    printf(" %9s\n", "total");
+
+    for (uint32_t i = 0; i < NUM_IMAGES; ++i) {
+        for (int direct = 1; direct >= 0; --direct) {
+            for (int n = 1; n <= MAX_THREADS; ++n) {
+                ret = run(&images[i], direct ? SYS_SPU_IMAGE_DIRECT : SYS_SPU_IMAGE_PROTECT, n, tbFreq);
+                if (ret != CELL_OK)
+                    return ret;
+            }
+        }
+    }
+    printf("done!\n");
+    return 0;
+}
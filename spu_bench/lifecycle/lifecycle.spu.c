@@ -0,0 +1,28 @@
+#include <stdint.h>
+#include <sys/spu_thread.h>
+
+/*
+ * Exits right away, the benchmark times everything around it. IMAGE_PAD
+ * bytes of initialized data make the image bigger, one build per size
+ */
+#ifndef IMAGE_PAD
+#define IMAGE_PAD 0
+#endif
+
+#if IMAGE_PAD > 0
+static volatile uint8_t pad[IMAGE_PAD] __attribute__((used)) = { 1 };
+#endif
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    (void)arg4;
+
+#if IMAGE_PAD > 0
+    sys_spu_thread_exit(pad[0] - 1);
+#endif
+    sys_spu_thread_exit(0);
+    return 0;
+}
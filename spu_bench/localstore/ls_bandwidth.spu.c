@@ -0,0 +1,192 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+
+#define LS_SIZE 0x40000
+// Write tests stay inside buf, read tests cover all of LS (code and stack
+// included, they are only read)
+#define BUF_SIZE 0x10000
+#define PASSES 64
+
+static qword buf[BUF_SIZE / 16] __attribute__((aligned(128)));
+
+/*
+ * 16 accesses per asm block, k*stride bytes apart so all offsets fit the
+ * lqd/stqd immediate up to a 512 byte stride. %0 is the loaded or stored
+ * register, %1 the block address
+ */
+#define ACC(op, k, stride) op " %0," #k "*" #stride "(%1)\n\t"
+#define ACCESS16(op, stride) \
+    ACC(op, 0, stride) ACC(op, 1, stride) ACC(op, 2, stride) ACC(op, 3, stride) \
+    ACC(op, 4, stride) ACC(op, 5, stride) ACC(op, 6, stride) ACC(op, 7, stride) \
+    ACC(op, 8, stride) ACC(op, 9, stride) ACC(op, 10, stride) ACC(op, 11, stride) \
+    ACC(op, 12, stride) ACC(op, 13, stride) ACC(op, 14, stride) ACC(op, 15, stride)
+
+/*
+ * Every pass touches each quadword of the region once: a block covers
+ * 16 * stride bytes, then the next block, then again shifted by 16 bytes
+ * until the whole stride is filled in
+ */
+#define STRIDED(stride) \
+static uint32_t read_##stride(void) \
+{ \
+    qword t; \
+    uint32_t start = dec_read(); \
+    for (int p = 0; p < PASSES; ++p) \
+        for (uint32_t first = 0; first < stride; first += 16) \
+            for (uint32_t a = first; a < LS_SIZE; a += 16 * stride) \
+                __asm__ volatile (ACCESS16("lqd", stride) : "=r"(t) : "r"(si_from_uint(a))); \
+    return dec_elapsed(start, dec_read()); \
+} \
+static uint32_t write_##stride(void) \
+{ \
+    qword v = (qword)spu_splats(0x5A5A5A5Au); \
+    uint32_t base = (uint32_t)buf; \
+    uint32_t start = dec_read(); \
+    for (int p = 0; p < PASSES; ++p) \
+        for (uint32_t first = 0; first < stride; first += 16) \
+            for (uint32_t a = base + first; a < base + BUF_SIZE; a += 16 * stride) \
+                __asm__ volatile (ACCESS16("stqd", stride) : : "r"(v), "r"(si_from_uint(a)) : "memory"); \
+    return dec_elapsed(start, dec_read()); \
+}
+
+STRIDED(16)
+STRIDED(64)
+STRIDED(128)
+STRIDED(512)
+
+/*
+ * Random offsets come from one full period 16 bit LCG, so its low bits walk
+ * every quadword of the region once per period. Each word slot runs its own
+ * quarter of the period, seeded that many steps apart. lqx/stqx only use the
+ * preferred slot, so 3 of every 4 offsets cost a rotate on the odd pipe on
+ * top of the access
+ */
+#define LCG_MUL 25173
+#define LCG_INC 13849
+
+static vec_uint4 lcg_seeds(uint32_t count)
+{
+    vec_uint4 seeds;
+    uint32_t x = 1;
+    for (int slot = 0; slot < 4; ++slot) {
+        seeds = spu_insert(x, seeds, slot);
+        for (uint32_t i = 0; i < count; ++i)
+            x = (x & 0xFFFF) * LCG_MUL + LCG_INC;
+    }
+    return seeds;
+}
+
+#define RANDOM_ACCESS(name, baseAddr, mask, BODY) \
+static uint32_t name(void) \
+{ \
+    qword t, v = (qword)spu_splats(0x5A5A5A5Au); \
+    qword base = si_from_uint(baseAddr); \
+    const vec_ushort8 mul = spu_splats((unsigned short)LCG_MUL); \
+    const vec_uint4 inc = spu_splats((unsigned int)LCG_INC); \
+    const vec_uint4 m = spu_splats((unsigned int)(mask)); \
+    uint32_t count = ((mask) + 16) / 16 / 4; \
+    vec_uint4 x = lcg_seeds(count); \
+    (void)t; \
+    (void)v; \
+    uint32_t start = dec_read(); \
+    for (int p = 0; p < PASSES; ++p) \
+        for (uint32_t i = 0; i < count; ++i) { \
+            x = spu_add(spu_mulo((vec_ushort8)x, mul), inc); \
+            vec_uint4 off = spu_and(spu_sl(x, 4), m); \
+            BODY(0) BODY(1) BODY(2) BODY(3) \
+        } \
+    return dec_elapsed(start, dec_read()); \
+}
+
+#define RANDOM_LOAD(i) \
+    __asm__ volatile ("lqx %0,%1,%2" : "=r"(t) : "r"(base), "r"(si_from_uint(spu_extract(off, i))));
+#define RANDOM_STORE(i) \
+    __asm__ volatile ("stqx %0,%1,%2" : : "r"(v), "r"(base), "r"(si_from_uint(spu_extract(off, i))) : "memory");
+
+RANDOM_ACCESS(read_random, 0, LS_SIZE - 16, RANDOM_LOAD)
+RANDOM_ACCESS(write_random, (uint32_t)buf, BUF_SIZE - 16, RANDOM_STORE)
+
+/*
+ * Scalar stores, lqd + c?d + shufb + stqd is what spu-gcc emits for a store
+ * through a pointer to anything smaller than a quadword. With step < 16
+ * consecutive stores hit the same quadword and each load waits for the
+ * previous store, step 16 has no such dependency
+ */
+#define SCALAR_STORE(gen, step) \
+static uint32_t gen##_##step(void) \
+{ \
+    qword v = (qword)spu_splats(0x5A5A5A5Au); \
+    uint32_t base = (uint32_t)buf; \
+    uint32_t start = dec_read(); \
+    for (int p = 0; p < PASSES; ++p) \
+        for (uint32_t a = base; a < base + BUF_SIZE; a += step) { \
+            qword addr = si_from_uint(a); \
+            qword q = si_lqd(addr, 0); \
+            si_stqd(si_shufb(v, q, si_##gen(addr, 0)), addr, 0); \
+        } \
+    return dec_elapsed(start, dec_read()); \
+}
+
+SCALAR_STORE(cbd, 1)
+SCALAR_STORE(chd, 2)
+SCALAR_STORE(cwd, 4)
+SCALAR_STORE(cdd, 8)
+SCALAR_STORE(cwd, 16)
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(void);
+    uint32_t accesses;      // per pass
+    uint32_t bytes;         // useful bytes per access
+} ls_test_t;
+
+static const ls_test_t tests[] = {
+    { "read seq", read_16, LS_SIZE / 16, 16 },
+    { "read 64", read_64, LS_SIZE / 16, 16 },
+    { "read 128", read_128, LS_SIZE / 16, 16 },
+    { "read 512", read_512, LS_SIZE / 16, 16 },
+    { "read random", read_random, LS_SIZE / 16, 16 },
+    { "write seq", write_16, BUF_SIZE / 16, 16 },
+    { "write 64", write_64, BUF_SIZE / 16, 16 },
+    { "write 128", write_128, BUF_SIZE / 16, 16 },
+    { "write 512", write_512, BUF_SIZE / 16, 16 },
+    { "write random", write_random, BUF_SIZE / 16, 16 },
+    { "cbd+shufb", cbd_1, BUF_SIZE, 1 },
+    { "chd+shufb", chd_2, BUF_SIZE / 2, 2 },
+    { "cwd+shufb", cwd_4, BUF_SIZE / 4, 4 },
+    { "cdd+shufb", cdd_8, BUF_SIZE / 8, 8 },
+    { "cwd+shufb 16", cwd_16, BUF_SIZE / 16, 4 },
+};
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg1;
+    (void)arg3;
+    (void)arg4;
+    uint64_t tbFreq = arg2;
+
+    dec_init();
+
+    spu_printf("spu local store bandwidth, %d passes, cycles at %d MHz\n", PASSES, (int)(SPU_CLOCK / 1000000));
+    spu_printf("%-14s %10s %10s %10s %8s\n", "test", "accesses", "cyc/acc", "bytes/cyc", "GB/s");
+
+    for (uint32_t i = 0; i < NUM_TESTS; ++i) {
+        const ls_test_t *t = &tests[i];
+        uint32_t ticks = t->run();
+        uint64_t accesses = (uint64_t)t->accesses * PASSES;
+        double cycles = ticks_to_cycles(ticks, 1, tbFreq);
+        double seconds = (double)ticks / (double)tbFreq;
+
+        uint32_t perAccess = to_hundredths(cycles / accesses);
+        uint32_t perCycle = to_hundredths(accesses * t->bytes / cycles);
+        uint32_t gbs = to_hundredths(accesses * t->bytes / seconds / 1e9);
+        spu_printf("%-14s %10u %7u.%02u %7u.%02u %5u.%02u\n", t->name, (uint32_t)accesses,
+                   FIXED2(perAccess), FIXED2(perCycle), FIXED2(gbs));
+    }
+
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * Shared between mailbox_bench.spu.c and mailbox_bench.ppu.c, both sides
+ * walk through the mechanisms in enum order
+ */
+#pragma once
+
+#define MAILBOX_ROUNDS 10000
+
+// SPU port for sys_spu_thread_send/throw_event, clear of the spu_printf one
+#define MAILBOX_SPU_PORT 20
+// key the PPU -> SPU event queue is bound to
+#define MAILBOX_SPU_QUEUE 0x20
+#define MAILBOX_SPU_QUEUE_SIZE 32
+
+/*
+ * PPU -> SPU: the SPU acks every message by DMAing its running count to
+ * the PPU, MAILBOX_ROUNDS round trips then MAILBOX_ROUNDS streamed
+ */
+enum {
+    MAILBOX_IN_MBOX,
+    MAILBOX_SNR1,
+    MAILBOX_SNR2,
+    MAILBOX_EVENT_PORT,
+    MAILBOX_PPU_TO_SPU
+};
@@ -0,0 +1,200 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ppu_intrinsics.h>
+#include <sys/event.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "mailbox_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_mailbox_bench_spu_out_start[];
+
+// running count of messages the SPU got, DMAed here after every one
+static volatile uint32_t ack __attribute__((aligned(128)));
+
+static sys_spu_thread_t thread;
+static sys_event_queue_t ppuQueue;      // SPU -> PPU user events
+static sys_event_queue_t spuQueue;      // PPU -> SPU, bound to the thread
+static sys_event_port_t port;
+
+static const char *mechNames[MAILBOX_PPU_TO_SPU] = { "in mbox", "snr1", "snr2", "event port" };
+// messages in flight when streaming: mailbox depth, SNRs are in overwrite mode
+static const uint32_t windows[MAILBOX_PPU_TO_SPU] = { 4, 1, 1, MAILBOX_SPU_QUEUE_SIZE / 2 };
+
+static int send(int mech, uint32_t value)
+{
+    switch (mech) {
+    case MAILBOX_IN_MBOX:
+        return sys_spu_thread_write_spu_mb(thread, value);
+    case MAILBOX_SNR1:
+        return sys_spu_thread_write_snr(thread, 0, value);
+    case MAILBOX_SNR2:
+        return sys_spu_thread_write_snr(thread, 1, value);
+    case MAILBOX_EVENT_PORT:
+        return sys_event_port_send(port, value, 0, 0);
+    }
+    return -1;
+}
+
+static void print_result(const char *name, uint64_t pingTicks, uint64_t streamTicks, uint64_t tbFreq)
+{
+    double rtUs = (double)pingTicks * 1e6 / (double)tbFreq / MAILBOX_ROUNDS;
+    printf("%-14s %10.2f us %12.0f msgs/s", name, rtUs, (double)MAILBOX_ROUNDS * (double)tbFreq / (double)pingTicks);
+    if (streamTicks)
+        printf(" %12.0f msgs/s\n", (double)MAILBOX_ROUNDS * (double)tbFreq / (double)streamTicks);
+    else
+        printf(" %12s\n", "-");
+}
+
+static int run_ppu_to_spu(int mech, uint64_t tbFreq)
+{
+    uint32_t base = 2 * MAILBOX_ROUNDS * mech;
+    int ret;
+
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        if ((ret = send(mech, i)) != CELL_OK)
+            return ret;
+        while (ack != base + i + 1)
+            ;
+    }
+    uint64_t pingTicks = __mftb() - start;
+
+    base += MAILBOX_ROUNDS;
+    start = __mftb();
+    for (uint32_t sent = 0; sent < MAILBOX_ROUNDS; ++sent) {
+        while (sent - (ack - base) >= windows[mech])
+            ;
+        if ((ret = send(mech, sent)) != CELL_OK)
+            return ret;
+    }
+    while (ack != base + MAILBOX_ROUNDS)
+        ;
+    uint64_t streamTicks = __mftb() - start;
+
+    print_result(mechNames[mech], pingTicks, streamTicks, tbFreq);
+    return CELL_OK;
+}
+
+static int run_spu_to_ppu(uint64_t tbFreq)
+{
+    sys_event_t ev;
+    int ret;
+
+    // send_event round trips, then streamed
+    uint64_t start = __mftb();
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        if ((ret = sys_event_queue_receive(ppuQueue, &ev, SYS_NO_TIMEOUT)) != CELL_OK)
+            return ret;
+        sys_spu_thread_write_spu_mb(thread, i);
+    }
+    uint64_t pingTicks = __mftb() - start;
+
+    start = __mftb();
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        if ((ret = sys_event_queue_receive(ppuQueue, &ev, SYS_NO_TIMEOUT)) != CELL_OK)
+            return ret;
+    }
+    uint64_t streamTicks = __mftb() - start;
+    print_result("send_event", pingTicks, streamTicks, tbFreq);
+
+    // throw_event can be dropped on a full queue, so round trips only
+    start = __mftb();
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        if ((ret = sys_event_queue_receive(ppuQueue, &ev, SYS_NO_TIMEOUT)) != CELL_OK)
+            return ret;
+        sys_spu_thread_write_spu_mb(thread, i);
+    }
+    print_result("throw_event", __mftb() - start, 0, tbFreq);
+    return CELL_OK;
+}
+
+static int connect_queues(void)
+{
+    sys_event_queue_attribute_t attr;
+    int ret;
+
+    sys_event_queue_attribute_initialize(attr);
+    if ((ret = sys_event_queue_create(&ppuQueue, &attr, SYS_EVENT_QUEUE_LOCAL, 127)) != CELL_OK) {
+        printf("sys_event_queue_create: %x\n", ret);
+        return ret;
+    }
+    if ((ret = sys_spu_thread_connect_event(thread, ppuQueue, SYS_SPU_THREAD_EVENT_USER, MAILBOX_SPU_PORT)) != CELL_OK) {
+        printf("sys_spu_thread_connect_event: %x\n", ret);
+        return ret;
+    }
+
+    sys_event_queue_attribute_initialize(attr);
+    attr.type = SYS_SPU_QUEUE;
+    if ((ret = sys_event_queue_create(&spuQueue, &attr, SYS_EVENT_QUEUE_LOCAL, MAILBOX_SPU_QUEUE_SIZE)) != CELL_OK) {
+        printf("sys_event_queue_create (spu): %x\n", ret);
+        return ret;
+    }
+    if ((ret = sys_spu_thread_bind_queue(thread, spuQueue, MAILBOX_SPU_QUEUE)) != CELL_OK) {
+        printf("sys_spu_thread_bind_queue: %x\n", ret);
+        return ret;
+    }
+    if ((ret = sys_event_port_create(&port, SYS_EVENT_PORT_LOCAL, SYS_EVENT_PORT_NO_NAME)) != CELL_OK) {
+        printf("sys_event_port_create: %x\n", ret);
+        return ret;
+    }
+    if ((ret = sys_event_port_connect_local(port, spuQueue)) != CELL_OK)
+        printf("sys_event_port_connect_local: %x\n", ret);
+    return ret;
+}
+
+static void disconnect_queues(void)
+{
+    sys_event_port_disconnect(port);
+    sys_event_port_destroy(port);
+    sys_spu_thread_unbind_queue(thread, MAILBOX_SPU_QUEUE);
+    sys_event_queue_destroy(spuQueue, SYS_EVENT_QUEUE_DESTROY_FORCE);
+    sys_spu_thread_disconnect_event(thread, SYS_SPU_THREAD_EVENT_USER, MAILBOX_SPU_PORT);
+    sys_event_queue_destroy(ppuQueue, SYS_EVENT_QUEUE_DESTROY_FORCE);
+}
+
+int main(void)
+{
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg1 = (uint64_t)(uintptr_t)&ack;
+    ack = 0;
+
+    spu_bench_group_t g;
+    int ret = spu_bench_start(&g, _binary_mailbox_bench_spu_out_start, 1, &args);
+    if (ret != CELL_OK) {
+        spu_bench_finalize();
+        return ret;
+    }
+    thread = g.threads[0];
+
+    printf("spu mailbox benchmark, %d messages per run\n", MAILBOX_ROUNDS);
+    printf("%-14s %13s %19s %19s\n", "mechanism", "round trip", "round trips", "streamed");
+
+    // a failure past this point leaves the SPU waiting, the join would hang
+    ret = connect_queues();
+    if (ret == CELL_OK)
+        ret = sys_spu_thread_write_spu_mb(thread, 0);
+    for (int mech = 0; ret == CELL_OK && mech < MAILBOX_PPU_TO_SPU; ++mech)
+        ret = run_ppu_to_spu(mech, tbFreq);
+    if (ret == CELL_OK)
+        ret = run_spu_to_ppu(tbFreq);
+
+    if (ret != CELL_OK) {
+        printf("failed: %x\n", ret);
+        sys_spu_thread_group_terminate(g.group, -1);
+    }
+    disconnect_queues();
+    spu_bench_join(&g, NULL);
+    spu_bench_finalize();
+    return ret;
+}
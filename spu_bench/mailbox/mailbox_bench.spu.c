@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <sys/return_code.h>
+#include <sys/spu_event.h>
+
+#include "../common/spu_bench_spu.h"
+#include "mailbox_bench.h"
+
+#define TAG 0
+
+static volatile uint32_t ack[4] __attribute__((aligned(16)));
+static uint64_t ackEa;
+static uint32_t acks;
+
+// the PPU waits for a running count over all mechanisms
+static void post_ack(void)
+{
+    ack[0] = ++acks;
+    mfc_put(ack, ackEa, 4, TAG, 0, 0);
+    mfc_write_tag_mask(1 << TAG);
+    mfc_read_tag_status_all();
+}
+
+static void receive(int mech)
+{
+    uint32_t d1, d2, d3;
+    switch (mech) {
+    case MAILBOX_IN_MBOX:
+        spu_read_in_mbox();
+        break;
+    case MAILBOX_SNR1:
+        spu_read_signal1();
+        break;
+    case MAILBOX_SNR2:
+        spu_read_signal2();
+        break;
+    case MAILBOX_EVENT_PORT:
+        sys_spu_thread_receive_event(MAILBOX_SPU_QUEUE, &d1, &d2, &d3);
+        break;
+    }
+}
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg2;
+    (void)arg3;
+    (void)arg4;
+    ackEa = arg1;
+
+    // the PPU connects the event queues and ports once the thread runs,
+    // then says go
+    spu_read_in_mbox();
+
+    for (int mech = 0; mech < MAILBOX_PPU_TO_SPU; ++mech) {
+        for (uint32_t i = 0; i < 2 * MAILBOX_ROUNDS; ++i) {
+            receive(mech);
+            post_ack();
+        }
+    }
+
+    /*
+     * SPU -> PPU: send_event goes through the outbound mailbox and the
+     * interrupt mailbox and waits for lv2's ack on the inbound mailbox,
+     * throw_event doesn't wait. The PPU answers round trips on the inbound
+     * mailbox
+     */
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        sys_spu_thread_send_event(MAILBOX_SPU_PORT, i & 0xFFFFFF, i);
+        spu_read_in_mbox();
+    }
+    // lv2 drops the event with EBUSY when the PPU queue is full, the PPU
+    // waits for all of them so send it again
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        while (sys_spu_thread_send_event(MAILBOX_SPU_PORT, i & 0xFFFFFF, i) == EBUSY)
+            ;
+    }
+    for (uint32_t i = 0; i < MAILBOX_ROUNDS; ++i) {
+        sys_spu_thread_throw_event(MAILBOX_SPU_PORT, i & 0xFFFFFF, i);
+        spu_read_in_mbox();
+    }
+
+    sys_spu_thread_exit(0);
+    return 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * Result layout shared by opcode_bench.spu.c and opcode_bench.ppu.c, the
+ * SPU DMAs the whole table to the address in its first argument
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define OPCODE_BENCH_MAX 128
+
+typedef struct {
+    char name[16];
+    uint32_t depTicks;      // one dependent chain, 0 if the op can't form one
+    uint32_t indTicks;      // 8 independent chains
+    uint32_t insns;         // instructions executed per run
+    uint32_t docLatency;    // latency from the CBE handbook, 0 if none
+} opcode_result_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t pad[3];
+    opcode_result_t ops[OPCODE_BENCH_MAX];
+} opcode_results_t __attribute__((aligned(128)));
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "opcode_bench.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+// /app_home is the host pc's directory when run from the debugger, pass
+// another path as argv[1] otherwise
+#define DEFAULT_CSV "/app_home/spu_opcode_bench.csv"
+
+/* embedded SPU ELF symbols */
+extern char _binary_opcode_bench_spu_out_start[];
+
+static opcode_results_t results;
+
+static int write_csv(const char *path, uint64_t tbFreq)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        printf("couldn't open %s, no csv written\n", path);
+        return -1;
+    }
+
+    double cyclesPerTick = (double)SPU_CLOCK / (double)tbFreq;
+    fprintf(f, "opcode,dep_ticks,ind_ticks,insns,latency_cycles,issue_cycles,doc_latency\n");
+    for (uint32_t i = 0; i < results.count && i < OPCODE_BENCH_MAX; ++i) {
+        const opcode_result_t *r = &results.ops[i];
+        fprintf(f, "%s,%u,%u,%u,", r->name, r->depTicks, r->indTicks, r->insns);
+        if (r->depTicks)
+            fprintf(f, "%.3f,", r->depTicks * cyclesPerTick / r->insns);
+        else
+            fprintf(f, ",");
+        fprintf(f, "%.3f,", r->indTicks * cyclesPerTick / r->insns);
+        if (r->docLatency)
+            fprintf(f, "%u\n", r->docLatency);
+        else
+            fprintf(f, "\n");
+    }
+    fclose(f);
+    printf("%u opcodes written to %s\n", results.count, path);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *csvPath = argc > 1 ? argv[1] : DEFAULT_CSV;
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    memset(&results, 0, sizeof(results));
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg1 = (uint64_t)(uintptr_t)&results;
+    args.arg2 = tbFreq;
+
+    int ret = spu_bench_run(_binary_opcode_bench_spu_out_start, 1, &args);
+    spu_bench_finalize();
+    if (ret != CELL_OK)
+        return ret;
+
+    return write_csv(csvPath, tbFreq);
+}
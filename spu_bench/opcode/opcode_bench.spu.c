@@ -0,0 +1,275 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "../common/spu_bench_spu.h"
+#include "opcode_bench.h"
+
+/*
+ * Every opcode runs LOOPS iterations of 32 instructions, either as one
+ * dependent chain (each instruction needs the previous result, gives the
+ * latency) or as 8 independent chains (gives the issue rate). The loop
+ * branch is 1 in 32 instructions and on the other pipe for most ops
+ */
+#define LOOPS 4096
+#define INSNS_PER_LOOP 32
+#define INSNS_PER_RUN (LOOPS * INSNS_PER_LOOP)
+
+typedef struct {
+    qword seed;     // start value of every chain
+    qword b, c;     // fixed second and third operands
+    qword ptr;      // store target for the store forms
+} bench_in_t;
+
+/*
+ * Operand forms, d is the chain register. %8/%9 are b/c, %10 is ptr
+ */
+#define RR(op, d)       op " %" #d ",%" #d ",%8\n\t"
+#define R1(op, d)       op " %" #d ",%" #d "\n\t"
+#define RI(op, imm, d)  op " %" #d ",%" #d "," #imm "\n\t"
+#define RRR(op, d)      op " %" #d ",%" #d ",%8,%9\n\t"
+#define ACC(op, d)      op " %" #d ",%8,%9\n\t"            // rt is also a source (dfma)
+#define IMM(op, imm, d) op " %" #d "," #imm "\n\t"
+#define GEN(op, d)      op " %" #d ",0(%" #d ")\n\t"       // cwd/cbd, address from the chain
+#define LQ(op, d)       op " %" #d ",0(%" #d ")\n\t"       // pointer chase
+#define LQX(op, d)      op " %" #d ",%" #d ",%9\n\t"
+#define STQ(op, d)      op " %" #d ",0(%10)\n\t"
+#define STQX(op, d)     op " %" #d ",%10,%9\n\t"
+#define SCR(op, d)      op " %" #d "\n\t"
+#define NONE(op, d)     op "\n\t"
+
+#define CHAIN8(FORM, ...) \
+    FORM(__VA_ARGS__, 0) FORM(__VA_ARGS__, 1) FORM(__VA_ARGS__, 2) FORM(__VA_ARGS__, 3) \
+    FORM(__VA_ARGS__, 4) FORM(__VA_ARGS__, 5) FORM(__VA_ARGS__, 6) FORM(__VA_ARGS__, 7)
+
+#define RUN_ASM(body) \
+    qword r0 = in->seed, r1 = in->seed, r2 = in->seed, r3 = in->seed; \
+    qword r4 = in->seed, r5 = in->seed, r6 = in->seed, r7 = in->seed; \
+    qword b = in->b, c = in->c, p = in->ptr; \
+    uint32_t start = dec_read(); \
+    for (int i = 0; i < LOOPS; ++i) \
+        __asm__ volatile (body \
+            : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3), "+r"(r4), "+r"(r5), "+r"(r6), "+r"(r7) \
+            : "r"(b), "r"(c), "r"(p) : "memory"); \
+    return dec_elapsed(start, dec_read());
+
+#define BENCH(id, FORM, ...) \
+static uint32_t id##_dep(const bench_in_t *in) \
+{ \
+    RUN_ASM(".rept 32\n\t" FORM(__VA_ARGS__, 0) ".endr\n\t") \
+} \
+static uint32_t id##_ind(const bench_in_t *in) \
+{ \
+    RUN_ASM(".rept 4\n\t" CHAIN8(FORM, __VA_ARGS__) ".endr\n\t") \
+}
+
+// fixed point, even pipe
+BENCH(a, RR, "a")
+BENCH(ah, RR, "ah")
+BENCH(sf, RR, "sf")
+BENCH(cg, RR, "cg")
+BENCH(addx, RR, "addx")
+BENCH(ai, RI, "ai", 1)
+BENCH(and, RR, "and")
+BENCH(or, RR, "or")
+BENCH(xor, RR, "xor")
+BENCH(nand, RR, "nand")
+BENCH(andi, RI, "andi", 0x7F)
+BENCH(selb, RRR, "selb")
+BENCH(ceq, RR, "ceq")
+BENCH(cgt, RR, "cgt")
+BENCH(clgt, RR, "clgt")
+BENCH(ceqi, RI, "ceqi", 0)
+BENCH(clz, R1, "clz")
+BENCH(xsbh, R1, "xsbh")
+BENCH(xshw, R1, "xshw")
+BENCH(shl, RR, "shl")
+BENCH(shli, RI, "shli", 3)
+BENCH(rot, RR, "rot")
+BENCH(roti, RI, "roti", 3)
+BENCH(rotm, RR, "rotm")
+BENCH(rotmai, RI, "rotmai", -3)
+BENCH(shlh, RR, "shlh")
+BENCH(cntb, R1, "cntb")
+BENCH(avgb, RR, "avgb")
+BENCH(absdb, RR, "absdb")
+BENCH(sumb, RR, "sumb")
+BENCH(mpy, RR, "mpy")
+BENCH(mpyu, RR, "mpyu")
+BENCH(mpyh, RR, "mpyh")
+BENCH(mpyhh, RR, "mpyhh")
+BENCH(mpyi, RI, "mpyi", 3)
+BENCH(mpya, RRR, "mpya")
+BENCH(il, IMM, "il", 0x1234)
+BENCH(ila, IMM, "ila", 0x12345)
+BENCH(ilhu, IMM, "ilhu", 0x1234)
+BENCH(iohl, IMM, "iohl", 0x1234)
+BENCH(nop, NONE, "nop")
+
+// permute, quadword shifts and loads/stores, odd pipe
+BENCH(shufb, RRR, "shufb")
+BENCH(shlqbi, RR, "shlqbi")
+BENCH(shlqbii, RI, "shlqbii", 3)
+BENCH(shlqby, RR, "shlqby")
+BENCH(shlqbyi, RI, "shlqbyi", 3)
+BENCH(rotqby, RR, "rotqby")
+BENCH(rotqbyi, RI, "rotqbyi", 3)
+BENCH(rotqmbyi, RI, "rotqmbyi", -3)
+BENCH(rotqbybi, RR, "rotqbybi")
+BENCH(fsmbi, IMM, "fsmbi", 0xF0F0)
+BENCH(fsmb, R1, "fsmb")
+BENCH(fsm, R1, "fsm")
+BENCH(gbb, R1, "gbb")
+BENCH(gb, R1, "gb")
+BENCH(orx, R1, "orx")
+BENCH(cbd, GEN, "cbd")
+BENCH(cwd, GEN, "cwd")
+BENCH(frest, R1, "frest")
+BENCH(frsqest, R1, "frsqest")
+BENCH(lqd, LQ, "lqd")
+BENCH(lqx, LQX, "lqx")
+BENCH(stqd, STQ, "stqd")
+BENCH(stqx, STQX, "stqx")
+BENCH(lnop, NONE, "lnop")
+
+// single precision
+BENCH(fa, RR, "fa")
+BENCH(fs, RR, "fs")
+BENCH(fm, RR, "fm")
+BENCH(fma, RRR, "fma")
+BENCH(fms, RRR, "fms")
+BENCH(fnms, RRR, "fnms")
+BENCH(fceq, RR, "fceq")
+BENCH(fcgt, RR, "fcgt")
+BENCH(fi, RR, "fi")
+BENCH(csflt, RI, "csflt", 0)
+BENCH(cflts, RI, "cflts", 0)
+
+// double precision
+BENCH(dfa, RR, "dfa")
+BENCH(dfs, RR, "dfs")
+BENCH(dfm, RR, "dfm")
+BENCH(dfma, ACC, "dfma")
+BENCH(dfms, ACC, "dfms")
+BENCH(dfnms, ACC, "dfnms")
+BENCH(dfnma, ACC, "dfnma")
+BENCH(fesd, R1, "fesd")
+BENCH(frds, R1, "frds")
+
+// status
+BENCH(fscrrd, SCR, "fscrrd")
+
+enum { K_INT, K_FLT, K_DBL, K_ADDR, K_COUNT };
+
+typedef struct {
+    const char *name;
+    int kind;           // which inputs
+    int chain;          // 0 if the result doesn't feed the next instruction
+    uint32_t docLatency;
+    uint32_t (*dep)(const bench_in_t *);
+    uint32_t (*ind)(const bench_in_t *);
+} op_entry_t;
+
+#define OP(id, kind, chain, lat) { #id, kind, chain, lat, id##_dep, id##_ind }
+
+// Latencies are the ones listed in the CBE Programming Handbook
+static const op_entry_t ops[] = {
+    OP(a, K_INT, 1, 2), OP(ah, K_INT, 1, 2), OP(sf, K_INT, 1, 2), OP(cg, K_INT, 1, 2),
+    OP(addx, K_INT, 1, 2), OP(ai, K_INT, 1, 2), OP(and, K_INT, 1, 2), OP(or, K_INT, 1, 2),
+    OP(xor, K_INT, 1, 2), OP(nand, K_INT, 1, 2), OP(andi, K_INT, 1, 2), OP(selb, K_INT, 1, 2),
+    OP(ceq, K_INT, 1, 2), OP(cgt, K_INT, 1, 2), OP(clgt, K_INT, 1, 2), OP(ceqi, K_INT, 1, 2),
+    OP(clz, K_INT, 1, 2), OP(xsbh, K_INT, 1, 2), OP(xshw, K_INT, 1, 2),
+    OP(shl, K_INT, 1, 4), OP(shli, K_INT, 1, 4), OP(rot, K_INT, 1, 4), OP(roti, K_INT, 1, 4),
+    OP(rotm, K_INT, 1, 4), OP(rotmai, K_INT, 1, 4), OP(shlh, K_INT, 1, 4),
+    OP(cntb, K_INT, 1, 4), OP(avgb, K_INT, 1, 4), OP(absdb, K_INT, 1, 4), OP(sumb, K_INT, 1, 4),
+    OP(mpy, K_INT, 1, 7), OP(mpyu, K_INT, 1, 7), OP(mpyh, K_INT, 1, 7), OP(mpyhh, K_INT, 1, 7),
+    OP(mpyi, K_INT, 1, 7), OP(mpya, K_INT, 1, 7),
+    OP(il, K_INT, 0, 2), OP(ila, K_INT, 0, 2), OP(ilhu, K_INT, 0, 2), OP(iohl, K_INT, 1, 2),
+    OP(nop, K_INT, 0, 0),
+
+    OP(shufb, K_INT, 1, 4), OP(shlqbi, K_INT, 1, 4), OP(shlqbii, K_INT, 1, 4), OP(shlqby, K_INT, 1, 4),
+    OP(shlqbyi, K_INT, 1, 4), OP(rotqby, K_INT, 1, 4), OP(rotqbyi, K_INT, 1, 4), OP(rotqmbyi, K_INT, 1, 4),
+    OP(rotqbybi, K_INT, 1, 4), OP(fsmbi, K_INT, 0, 4), OP(fsmb, K_INT, 1, 4), OP(fsm, K_INT, 1, 4),
+    OP(gbb, K_INT, 1, 4), OP(gb, K_INT, 1, 4), OP(orx, K_INT, 1, 4), OP(cbd, K_INT, 1, 4),
+    OP(cwd, K_INT, 1, 4), OP(frest, K_FLT, 1, 4), OP(frsqest, K_FLT, 1, 4),
+    OP(lqd, K_ADDR, 1, 6), OP(lqx, K_ADDR, 1, 6), OP(stqd, K_ADDR, 0, 0), OP(stqx, K_ADDR, 0, 0),
+    OP(lnop, K_INT, 0, 0),
+
+    OP(fa, K_FLT, 1, 6), OP(fs, K_FLT, 1, 6), OP(fm, K_FLT, 1, 6), OP(fma, K_FLT, 1, 6),
+    OP(fms, K_FLT, 1, 6), OP(fnms, K_FLT, 1, 6), OP(fceq, K_FLT, 1, 2), OP(fcgt, K_FLT, 1, 2),
+    OP(fi, K_FLT, 1, 7), OP(csflt, K_FLT, 1, 7), OP(cflts, K_FLT, 1, 7),
+
+    OP(dfa, K_DBL, 1, 13), OP(dfs, K_DBL, 1, 13), OP(dfm, K_DBL, 1, 13), OP(dfma, K_DBL, 1, 13),
+    OP(dfms, K_DBL, 1, 13), OP(dfnms, K_DBL, 1, 13), OP(dfnma, K_DBL, 1, 13),
+    OP(fesd, K_DBL, 1, 13), OP(frds, K_DBL, 1, 13),
+
+    OP(fscrrd, K_INT, 0, 0),
+};
+#define NUM_OPS (sizeof(ops) / sizeof(ops[0]))
+
+// lqd/lqx chase a quadword holding its own address, stores go to sink
+static qword chase __attribute__((aligned(16)));
+static qword sink[8] __attribute__((aligned(16)));
+static opcode_results_t results;
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg3;
+    (void)arg4;
+    uint64_t resultsEa = arg1;
+    uint64_t tbFreq = arg2;
+
+    bench_in_t inputs[K_COUNT];
+    qword sinkPtr = (qword)spu_splats((uint32_t)sink);
+    // ints: shift counts of 3, a byte identity shufb pattern in c
+    inputs[K_INT].seed = (qword)spu_splats(0x12345678u);
+    inputs[K_INT].b = (qword)spu_splats(3u);
+    inputs[K_INT].c = (qword)(vec_uint4){ 0x00010203, 0x04050607, 0x08090A0B, 0x0C0D0E0F };
+    // floats stay finite and normal: x*1, x+1, x*1+0.5
+    inputs[K_FLT].seed = (qword)spu_splats(1.0f);
+    inputs[K_FLT].b = (qword)spu_splats(1.0f);
+    inputs[K_FLT].c = (qword)spu_splats(0.5f);
+    // doubles: dfma chains compute 1*0 + x so they never leave 1.0
+    inputs[K_DBL].seed = (qword)spu_splats(1.0);
+    inputs[K_DBL].b = (qword)spu_splats(1.0);
+    inputs[K_DBL].c = (qword)spu_splats(0.0);
+    inputs[K_ADDR].seed = (qword)spu_splats((uint32_t)&chase);
+    inputs[K_ADDR].b = (qword)spu_splats(0u);
+    inputs[K_ADDR].c = (qword)spu_splats(0u);
+    for (int k = 0; k < K_COUNT; ++k)
+        inputs[k].ptr = sinkPtr;
+    chase = inputs[K_ADDR].seed;
+
+    dec_init();
+
+    spu_printf("spu opcode benchmark, %d instructions per run, cycles at %d MHz\n",
+               INSNS_PER_RUN, (int)(SPU_CLOCK / 1000000));
+    spu_printf("%-10s %10s %10s %6s\n", "opcode", "latency", "issue", "doc");
+
+    results.count = NUM_OPS;
+    for (uint32_t i = 0; i < NUM_OPS; ++i) {
+        const op_entry_t *op = &ops[i];
+        const bench_in_t *in = &inputs[op->kind];
+        opcode_result_t *r = &results.ops[i];
+
+        r->depTicks = op->chain ? op->dep(in) : 0;
+        r->indTicks = op->ind(in);
+        r->insns = INSNS_PER_RUN;
+        r->docLatency = op->docLatency;
+        strncpy(r->name, op->name, sizeof(r->name) - 1);
+
+        uint32_t ind = to_hundredths(ticks_to_cycles(r->indTicks, INSNS_PER_RUN, tbFreq));
+        if (op->chain) {
+            uint32_t dep = to_hundredths(ticks_to_cycles(r->depTicks, INSNS_PER_RUN, tbFreq));
+            spu_printf("%-10s %7u.%02u %7u.%02u %6u\n", op->name, FIXED2(dep), FIXED2(ind), op->docLatency);
+        }
+        else
+            spu_printf("%-10s %10s %7u.%02u %6s\n", op->name, "-", FIXED2(ind), "-");
+    }
+
+    if (resultsEa != 0)
+        dma_put_wait(&results, resultsEa, sizeof(results));
+
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
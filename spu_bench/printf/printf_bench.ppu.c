@@ -0,0 +1,33 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "../../spu_test/spu_log_ppu.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_printf_bench_spu_out_start[];
+
+static spu_log_ring_t logRing __attribute__((aligned(128)));
+
+int main(void)
+{
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+    if (spu_log_start(&logRing, 1) != CELL_OK) {
+        spu_bench_finalize();
+        return -1;
+    }
+
+    sys_spu_thread_argument_t args;
+    memset(&args, 0, sizeof(args));
+    args.arg1 = (uint64_t)(uintptr_t)&logRing;
+    args.arg2 = sys_time_get_timebase_frequency();
+
+    int ret = spu_bench_run(_binary_printf_bench_spu_out_start, 1, &args);
+    spu_log_stop();
+    spu_bench_finalize();
+    return ret;
+}
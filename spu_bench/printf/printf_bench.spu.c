@@ -0,0 +1,50 @@
+#include <stdint.h>
+
+#include "../common/spu_bench_spu.h"
+#include "../../spu_test/spu_log_spu.h"
+
+#define MESSAGES 1000
+
+// the shape of a failure dump line from test_runner.spu.c
+#define LINE(i) "%4d Output: 0x%08x 0x%08x 0x%08x 0x%08x\n", (i), (i) * 3u, (i) ^ 0xA5A5A5A5u, ~(i), (i) << 16
+
+static void print_rate(const char *name, uint32_t ticks, uint64_t tbFreq)
+{
+    uint32_t us = to_hundredths(ticks_to_ns(ticks, MESSAGES, tbFreq) / 1000.0);
+    uint32_t rate = to_hundredths((double)MESSAGES * (double)tbFreq / (double)ticks / 1000.0);
+    spu_printf("%-22s %8u.%02u us %8u.%02u k/s\n", name, FIXED2(us), FIXED2(rate));
+}
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg3;
+    (void)arg4;
+    uint64_t tbFreq = arg2;
+
+    dec_init();
+    spu_log_init(arg1);
+
+    // every call waits until the PPU has formatted and printed the line
+    uint32_t start = dec_read();
+    for (int i = 0; i < MESSAGES; ++i)
+        spu_printf(LINE(i));
+    uint32_t printfTicks = dec_elapsed(start, dec_read());
+
+    // formatted in local store, written to the ring 4KB at a time
+    start = dec_read();
+    for (int i = 0; i < MESSAGES; ++i)
+        spu_log_printf(LINE(i));
+    spu_log_flush();
+    uint32_t logTicks = dec_elapsed(start, dec_read());
+    spu_log_sync();
+    uint32_t drainTicks = dec_elapsed(start, dec_read());
+
+    spu_printf("spu printf benchmark, %d messages, time per message and messages per second\n", MESSAGES);
+    print_rate("spu_printf", printfTicks, tbFreq);
+    print_rate("spu_log_printf", logTicks, tbFreq);
+    print_rate("spu_log_printf printed", drainTicks, tbFreq);
+
+    spu_printf("done!\n");
+    sys_spu_thread_exit(0);
+    return 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * Per thread result of scaling.spu.c, every thread DMAs one of these to the
+ * address in its first argument
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define SUITE_RUNS 16
+#define KERNEL_LOOPS (1 << 20)
+
+typedef struct {
+    int32_t failures;       // of the first suite run, < 0 if it didn't bootstrap
+    uint32_t unstableRuns;  // later runs with a different failure count
+    uint32_t firstInsn;     // first failure record, if any
+    uint32_t firstAddr;
+    uint32_t suiteTicks;    // all SUITE_RUNS runs
+    uint32_t kernelTicks;
+    uint32_t checksum;      // of the compute kernel, the same on every SPU
+    uint32_t pad[25];
+} scaling_result_t __attribute__((aligned(128)));
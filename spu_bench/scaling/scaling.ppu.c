@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ppu_intrinsics.h>
+
+#include "../common/spu_bench_ppu.h"
+#include "scaling.h"
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/* embedded SPU ELF symbols */
+extern char _binary_scaling_spu_out_start[];
+
+static scaling_result_t results[SPU_BENCH_MAX_THREADS];
+
+/*
+ * Every thread does the same work, so n threads finishing in the time one
+ * takes is a speedup of n. The wall time is start to join on the PPU and
+ * includes the group setup
+ */
+static int run_group(int numThreads, double *wallMs, uint32_t refChecksum, int *failed)
+{
+    sys_spu_thread_argument_t args[SPU_BENCH_MAX_THREADS];
+    int status[SPU_BENCH_MAX_THREADS];
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+
+    memset(results, 0, sizeof(results));
+    memset(args, 0, sizeof(args));
+    for (int i = 0; i < numThreads; ++i) {
+        args[i].arg1 = (uint64_t)(uintptr_t)&results[i];
+        args[i].arg2 = tbFreq;
+        args[i].arg3 = i;
+    }
+
+    spu_bench_group_t g;
+    uint64_t start = __mftb();
+    int ret = spu_bench_start(&g, _binary_scaling_spu_out_start, numThreads, args);
+    if (ret != CELL_OK)
+        return ret;
+    ret = spu_bench_join(&g, status);
+    *wallMs = (double)(__mftb() - start) * 1000.0 / (double)tbFreq;
+    if (ret != CELL_OK)
+        return ret;
+
+    for (int i = 0; i < numThreads; ++i) {
+        const scaling_result_t *r = &results[i];
+        printf("  spu %d: %d failed", i, r->failures);
+        if (r->failures > 0)
+            printf(" (first 0x%08x at 0x%x)", r->firstInsn, r->firstAddr);
+        if (r->unstableRuns)
+            printf(", %u runs disagreed", r->unstableRuns);
+        printf(", suite %.2f ms, kernel %.2f ms", (double)r->suiteTicks * 1000.0 / (double)tbFreq,
+               (double)r->kernelTicks * 1000.0 / (double)tbFreq);
+        if (refChecksum != 0 && r->checksum != refChecksum)
+            printf(", checksum 0x%08x expected 0x%08x", r->checksum, refChecksum);
+        printf("\n");
+
+        if (r->failures != 0 || r->unstableRuns || (refChecksum != 0 && r->checksum != refChecksum))
+            *failed = 1;
+    }
+    return CELL_OK;
+}
+
+int main(void)
+{
+    if (spu_bench_init() != CELL_OK)
+        return -1;
+
+    printf("spu scaling, %d suite runs and %d kernel loops per spu\n", SUITE_RUNS, KERNEL_LOOPS);
+
+    double wall1 = 0.0;
+    uint32_t refChecksum = 0;
+    int failed = 0;
+    for (int n = 1; n <= SPU_BENCH_MAX_THREADS; ++n) {
+        double wallMs;
+        printf("%d spu%s\n", n, n > 1 ? "s" : "");
+        int ret = run_group(n, &wallMs, refChecksum, &failed);
+        if (ret != CELL_OK) {
+            spu_bench_finalize();
+            return ret;
+        }
+        if (n == 1) {
+            wall1 = wallMs;
+            refChecksum = results[0].checksum;
+        }
+        printf("  wall %.2f ms, speedup %.2fx (ideal %d)\n", wallMs, n * wall1 / wallMs, n);
+    }
+
+    spu_bench_finalize();
+    printf(failed ? "FAILED\n" : "all spus passed\n");
+    return failed;
+}
@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "../common/spu_bench_spu.h"
+#include "scaling.h"
+
+extern vec_int4 test(vec_int4 r3, void *scratch, void *failures, vec_int4 r6);
+
+static char scratchBuf[8192] __attribute__((aligned(128)));
+static char failedBuf[65536] __attribute__((aligned(128)));
+static scaling_result_t result;
+
+static int run_suite(void)
+{
+    // cell-spu.s wants the scratch block cleared on entry
+    memset(scratchBuf, 0, sizeof(scratchBuf));
+    vec_int4 res = test((vec_int4){0,0,0,0}, scratchBuf, failedBuf, (vec_int4){0,1,2,4});
+    return spu_extract(res, 0);
+}
+
+/*
+ * 8 independent fma chains of x*0.5+0.25 (they settle on 0.5 and stay
+ * normal), enough to keep the even pipe busy with no LS or DMA traffic
+ */
+static uint32_t compute_kernel(uint32_t seed)
+{
+    const vec_float4 a = spu_splats(0.5f);
+    const vec_float4 b = spu_splats(0.25f);
+    vec_float4 x[8];
+    for (int i = 0; i < 8; ++i)
+        x[i] = spu_splats((float)(seed + i));
+
+    for (uint32_t n = 0; n < KERNEL_LOOPS; ++n) {
+        x[0] = spu_madd(x[0], a, b);
+        x[1] = spu_madd(x[1], a, b);
+        x[2] = spu_madd(x[2], a, b);
+        x[3] = spu_madd(x[3], a, b);
+        x[4] = spu_madd(x[4], a, b);
+        x[5] = spu_madd(x[5], a, b);
+        x[6] = spu_madd(x[6], a, b);
+        x[7] = spu_madd(x[7], a, b);
+    }
+
+    vec_uint4 sum = spu_splats(0u);
+    for (int i = 0; i < 8; ++i)
+        sum = spu_add(sum, (vec_uint4)x[i]);
+    return spu_extract(sum, 0) ^ spu_extract(sum, 1) ^ spu_extract(sum, 2) ^ spu_extract(sum, 3);
+}
+
+int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+    (void)arg2;
+    (void)arg4;
+    uint64_t resultEa = arg1;
+    uint32_t index = (uint32_t)arg3;
+
+    dec_init();
+
+    uint32_t start = dec_read();
+    result.failures = run_suite();
+    if (result.failures > 0) {
+        const uint32_t *rec = (const uint32_t *)failedBuf;
+        result.firstInsn = rec[0];
+        result.firstAddr = rec[1];
+    }
+    for (int i = 1; i < SUITE_RUNS; ++i) {
+        if (run_suite() != result.failures)
+            ++result.unstableRuns;
+    }
+    result.suiteTicks = dec_elapsed(start, dec_read());
+
+    start = dec_read();
+    // same seed everywhere so the checksums can be compared
+    result.checksum = compute_kernel(1);
+    result.kernelTicks = dec_elapsed(start, dec_read());
+
+    dma_put_wait(&result, resultEa, sizeof(result));
+
+    // only the first thread talks, the PPU prints the per SPU table
+    if (index == 0)
+        spu_printf("done!\n");
+    sys_spu_thread_exit(result.failures);
+    return 0;
+}
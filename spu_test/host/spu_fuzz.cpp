@@ -0,0 +1,714 @@
+// spu_fuzz.cpp : randomized differential tests for the SPU.
+//
+// Generates SPU test programs in the spirit of cell-spu.s, but with random
+// operands: every vector loads random ra/rb/rc/rt quadwords (and a random
+// double precision rounding mode), runs one instruction with random
+// immediates and compares the result and FPSCR against what the host
+// reference interpreter computed. The program has the same `test` entry as
+// cell-spu.s and writes the same 64 byte failure records, so it builds and
+// runs with test_runner.spu.c, raw_boot.s or spu_host_runner unchanged.
+//
+// Vector n only depends on the seed and n, so a run is split into shards
+// by giving each program its own range of vector numbers. Word 2 of a
+// failure record holds the vector number, -d decodes records back into the
+// instruction and operands.
+//
+// usage: spu_fuzz [-s seed] [-f first] [-n count] [-o out.s] [-x] [-d records.bin]
+//
+
+#include "spu_interpreter.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One program holds at most as many vectors as the 64KB failure buffer has
+// records, which also keeps it clear of the runner buffers at 0x29FF0
+const u32 MAX_VECTORS = 1024;
+// test_runner.spu.c keeps 72KB of buffers on the stack next to the image,
+// 512 vectors leave room for them
+const u32 DEFAULT_VECTORS = 512;
+// Largest program that still links with test_runner.spu.c: 256KB of LS less
+// its 72KB of stack buffers and 64KB for crt0, the printf and log code, the
+// log batch and the rest of the stack
+const u32 RUNNER_MAX_PROGRAM = 0x40000 - 72 * 1024 - 64 * 1024;
+const u32 BLOCK_VECTORS = 16;        // vectors per literal pool, keeps lqr in range
+
+// Local store layout for -x, the same as spu_host_runner
+const u32 LOAD_ADDR = 0;
+const u32 STACK_TOP = 0x3FFF0;
+const u32 FAILURES_ADDR = 0x2C000;
+const u32 SCRATCH_ADDR = 0x2A000;
+const u32 RETURN_ADDR = 0x29FF0;
+const u32 STOP_RETURN = 0x102;
+
+// Registers used by the generated code, the instruction under test always
+// writes R3 and reads R10-R12
+const u32 R_RESULT = 3;
+const u32 R_RECORD = 6;
+const u32 R_INDEX = 7;
+const u32 R_EXPECT = 8;
+const u32 R_EXPECT_FPSCR = 9;
+const u32 R_SRC = 10;
+const u32 R_FPSCR_IN = 13;
+const u32 R_LINK = 79;
+
+//--------------------------------------------------------------------------
+// Random numbers, splitmix64 seeded per vector
+//--------------------------------------------------------------------------
+struct Rng
+{
+    u64 state;
+
+    Rng(u64 seed, u64 index) : state(seed ^ (index * 0x9E3779B97F4A7C15ULL)) { next64(); }
+
+    u64 next64()
+    {
+        u64 z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    u32 next32() { return (u32)(next64() >> 32); }
+    u32 below(u32 n) { return (u32)(((u64)next32() * n) >> 32); }
+};
+
+//--------------------------------------------------------------------------
+// Instructions under test
+//--------------------------------------------------------------------------
+enum Form
+{
+    FORM_RR,     // rt,ra,rb
+    FORM_RR1,    // rt,ra
+    FORM_RRR,    // rt,ra,rb,rc
+    FORM_RI7,    // rt,ra,i7
+    FORM_RI8,    // rt,ra,scale
+    FORM_RI10,   // rt,ra,i10
+    FORM_RI16,   // rt,i16
+    FORM_RI18,   // rt,i18
+};
+
+// What the operands should look like
+enum Kind
+{
+    KIND_INT,
+    KIND_SP,
+    KIND_DP,
+};
+
+struct InsnInfo
+{
+    const char *name;
+    u32 opcode;
+    int bits;
+    Form form;
+    Kind kind;
+    int scaleBias;   // RI8 only, the assembler operand is scaleBias - i8
+};
+
+// Everything that maps registers to a register: loads, stores, branches,
+// hints, channels, SPRs, stop and the halts are left out, and so are
+// frest, frsqest and fi whose exact table values the reference doesn't
+// model
+static const InsnInfo insns[] =
+{
+    { "selb", 0x8, 4, FORM_RRR, KIND_INT, 0 }, { "shufb", 0xB, 4, FORM_RRR, KIND_INT, 0 },
+    { "mpya", 0xC, 4, FORM_RRR, KIND_INT, 0 }, { "fnms", 0xD, 4, FORM_RRR, KIND_SP, 0 },
+    { "fma", 0xE, 4, FORM_RRR, KIND_SP, 0 }, { "fms", 0xF, 4, FORM_RRR, KIND_SP, 0 },
+
+    { "ila", 0x21, 7, FORM_RI18, KIND_INT, 0 },
+
+    { "ori", 0x04, 8, FORM_RI10, KIND_INT, 0 }, { "orhi", 0x05, 8, FORM_RI10, KIND_INT, 0 },
+    { "orbi", 0x06, 8, FORM_RI10, KIND_INT, 0 }, { "sfi", 0x0C, 8, FORM_RI10, KIND_INT, 0 },
+    { "sfhi", 0x0D, 8, FORM_RI10, KIND_INT, 0 }, { "andi", 0x14, 8, FORM_RI10, KIND_INT, 0 },
+    { "andhi", 0x15, 8, FORM_RI10, KIND_INT, 0 }, { "andbi", 0x16, 8, FORM_RI10, KIND_INT, 0 },
+    { "ai", 0x1C, 8, FORM_RI10, KIND_INT, 0 }, { "ahi", 0x1D, 8, FORM_RI10, KIND_INT, 0 },
+    { "xori", 0x44, 8, FORM_RI10, KIND_INT, 0 }, { "xorhi", 0x45, 8, FORM_RI10, KIND_INT, 0 },
+    { "xorbi", 0x46, 8, FORM_RI10, KIND_INT, 0 }, { "cgti", 0x4C, 8, FORM_RI10, KIND_INT, 0 },
+    { "cgthi", 0x4D, 8, FORM_RI10, KIND_INT, 0 }, { "cgtbi", 0x4E, 8, FORM_RI10, KIND_INT, 0 },
+    { "clgti", 0x5C, 8, FORM_RI10, KIND_INT, 0 }, { "clgthi", 0x5D, 8, FORM_RI10, KIND_INT, 0 },
+    { "clgtbi", 0x5E, 8, FORM_RI10, KIND_INT, 0 }, { "mpyi", 0x74, 8, FORM_RI10, KIND_INT, 0 },
+    { "mpyui", 0x75, 8, FORM_RI10, KIND_INT, 0 }, { "ceqi", 0x7C, 8, FORM_RI10, KIND_INT, 0 },
+    { "ceqhi", 0x7D, 8, FORM_RI10, KIND_INT, 0 }, { "ceqbi", 0x7E, 8, FORM_RI10, KIND_INT, 0 },
+
+    { "fsmbi", 0x065, 9, FORM_RI16, KIND_INT, 0 }, { "il", 0x081, 9, FORM_RI16, KIND_INT, 0 },
+    { "ilhu", 0x082, 9, FORM_RI16, KIND_INT, 0 }, { "ilh", 0x083, 9, FORM_RI16, KIND_INT, 0 },
+    { "iohl", 0x0C1, 9, FORM_RI16, KIND_INT, 0 },
+
+    { "cflts", 0x1D8, 10, FORM_RI8, KIND_SP, 173 }, { "cfltu", 0x1D9, 10, FORM_RI8, KIND_SP, 173 },
+    { "csflt", 0x1DA, 10, FORM_RI8, KIND_INT, 155 }, { "cuflt", 0x1DB, 10, FORM_RI8, KIND_INT, 155 },
+
+    { "sf", 0x040, 11, FORM_RR, KIND_INT, 0 }, { "or", 0x041, 11, FORM_RR, KIND_INT, 0 },
+    { "bg", 0x042, 11, FORM_RR, KIND_INT, 0 }, { "sfh", 0x048, 11, FORM_RR, KIND_INT, 0 },
+    { "nor", 0x049, 11, FORM_RR, KIND_INT, 0 }, { "absdb", 0x053, 11, FORM_RR, KIND_INT, 0 },
+    { "rot", 0x058, 11, FORM_RR, KIND_INT, 0 }, { "rotm", 0x059, 11, FORM_RR, KIND_INT, 0 },
+    { "rotma", 0x05A, 11, FORM_RR, KIND_INT, 0 }, { "shl", 0x05B, 11, FORM_RR, KIND_INT, 0 },
+    { "roth", 0x05C, 11, FORM_RR, KIND_INT, 0 }, { "rothm", 0x05D, 11, FORM_RR, KIND_INT, 0 },
+    { "rotmah", 0x05E, 11, FORM_RR, KIND_INT, 0 }, { "shlh", 0x05F, 11, FORM_RR, KIND_INT, 0 },
+    { "roti", 0x078, 11, FORM_RI7, KIND_INT, 0 }, { "rotmi", 0x079, 11, FORM_RI7, KIND_INT, 0 },
+    { "rotmai", 0x07A, 11, FORM_RI7, KIND_INT, 0 }, { "shli", 0x07B, 11, FORM_RI7, KIND_INT, 0 },
+    { "rothi", 0x07C, 11, FORM_RI7, KIND_INT, 0 }, { "rothmi", 0x07D, 11, FORM_RI7, KIND_INT, 0 },
+    { "rotmahi", 0x07E, 11, FORM_RI7, KIND_INT, 0 }, { "shlhi", 0x07F, 11, FORM_RI7, KIND_INT, 0 },
+    { "a", 0x0C0, 11, FORM_RR, KIND_INT, 0 }, { "and", 0x0C1, 11, FORM_RR, KIND_INT, 0 },
+    { "cg", 0x0C2, 11, FORM_RR, KIND_INT, 0 }, { "ah", 0x0C8, 11, FORM_RR, KIND_INT, 0 },
+    { "nand", 0x0C9, 11, FORM_RR, KIND_INT, 0 }, { "avgb", 0x0D3, 11, FORM_RR, KIND_INT, 0 },
+    { "gb", 0x1B0, 11, FORM_RR1, KIND_INT, 0 }, { "gbh", 0x1B1, 11, FORM_RR1, KIND_INT, 0 },
+    { "gbb", 0x1B2, 11, FORM_RR1, KIND_INT, 0 }, { "fsm", 0x1B4, 11, FORM_RR1, KIND_INT, 0 },
+    { "fsmh", 0x1B5, 11, FORM_RR1, KIND_INT, 0 }, { "fsmb", 0x1B6, 11, FORM_RR1, KIND_INT, 0 },
+    { "rotqbybi", 0x1CC, 11, FORM_RR, KIND_INT, 0 }, { "rotqmbybi", 0x1CD, 11, FORM_RR, KIND_INT, 0 },
+    { "shlqbybi", 0x1CF, 11, FORM_RR, KIND_INT, 0 },
+    { "cbx", 0x1D4, 11, FORM_RR, KIND_INT, 0 }, { "chx", 0x1D5, 11, FORM_RR, KIND_INT, 0 },
+    { "cwx", 0x1D6, 11, FORM_RR, KIND_INT, 0 }, { "cdx", 0x1D7, 11, FORM_RR, KIND_INT, 0 },
+    { "rotqbi", 0x1D8, 11, FORM_RR, KIND_INT, 0 }, { "rotqmbi", 0x1D9, 11, FORM_RR, KIND_INT, 0 },
+    { "shlqbi", 0x1DB, 11, FORM_RR, KIND_INT, 0 },
+    { "rotqby", 0x1DC, 11, FORM_RR, KIND_INT, 0 }, { "rotqmby", 0x1DD, 11, FORM_RR, KIND_INT, 0 },
+    { "shlqby", 0x1DF, 11, FORM_RR, KIND_INT, 0 }, { "orx", 0x1F0, 11, FORM_RR1, KIND_INT, 0 },
+    { "cbd", 0x1F4, 11, FORM_RI7, KIND_INT, 0 }, { "chd", 0x1F5, 11, FORM_RI7, KIND_INT, 0 },
+    { "cwd", 0x1F6, 11, FORM_RI7, KIND_INT, 0 }, { "cdd", 0x1F7, 11, FORM_RI7, KIND_INT, 0 },
+    { "rotqbii", 0x1F8, 11, FORM_RI7, KIND_INT, 0 }, { "rotqmbii", 0x1F9, 11, FORM_RI7, KIND_INT, 0 },
+    { "shlqbii", 0x1FB, 11, FORM_RI7, KIND_INT, 0 },
+    { "rotqbyi", 0x1FC, 11, FORM_RI7, KIND_INT, 0 }, { "rotqmbyi", 0x1FD, 11, FORM_RI7, KIND_INT, 0 },
+    { "shlqbyi", 0x1FF, 11, FORM_RI7, KIND_INT, 0 },
+    { "cgt", 0x240, 11, FORM_RR, KIND_INT, 0 }, { "xor", 0x241, 11, FORM_RR, KIND_INT, 0 },
+    { "cgth", 0x248, 11, FORM_RR, KIND_INT, 0 }, { "eqv", 0x249, 11, FORM_RR, KIND_INT, 0 },
+    { "cgtb", 0x250, 11, FORM_RR, KIND_INT, 0 }, { "sumb", 0x253, 11, FORM_RR, KIND_INT, 0 },
+    { "clz", 0x2A5, 11, FORM_RR1, KIND_INT, 0 }, { "xswd", 0x2A6, 11, FORM_RR1, KIND_INT, 0 },
+    { "xshw", 0x2AE, 11, FORM_RR1, KIND_INT, 0 }, { "cntb", 0x2B4, 11, FORM_RR1, KIND_INT, 0 },
+    { "xsbh", 0x2B6, 11, FORM_RR1, KIND_INT, 0 },
+    { "clgt", 0x2C0, 11, FORM_RR, KIND_INT, 0 }, { "andc", 0x2C1, 11, FORM_RR, KIND_INT, 0 },
+    { "fcgt", 0x2C2, 11, FORM_RR, KIND_SP, 0 }, { "fa", 0x2C4, 11, FORM_RR, KIND_SP, 0 },
+    { "fs", 0x2C5, 11, FORM_RR, KIND_SP, 0 }, { "fm", 0x2C6, 11, FORM_RR, KIND_SP, 0 },
+    { "clgth", 0x2C8, 11, FORM_RR, KIND_INT, 0 }, { "orc", 0x2C9, 11, FORM_RR, KIND_INT, 0 },
+    { "fcmgt", 0x2CA, 11, FORM_RR, KIND_SP, 0 },
+    { "dfa", 0x2CC, 11, FORM_RR, KIND_DP, 0 }, { "dfs", 0x2CD, 11, FORM_RR, KIND_DP, 0 },
+    { "dfm", 0x2CE, 11, FORM_RR, KIND_DP, 0 }, { "clgtb", 0x2D0, 11, FORM_RR, KIND_INT, 0 },
+    { "addx", 0x340, 11, FORM_RR, KIND_INT, 0 }, { "sfx", 0x341, 11, FORM_RR, KIND_INT, 0 },
+    { "cgx", 0x342, 11, FORM_RR, KIND_INT, 0 }, { "bgx", 0x343, 11, FORM_RR, KIND_INT, 0 },
+    { "mpyhha", 0x346, 11, FORM_RR, KIND_INT, 0 }, { "mpyhhau", 0x34E, 11, FORM_RR, KIND_INT, 0 },
+    { "dfma", 0x35C, 11, FORM_RR, KIND_DP, 0 }, { "dfms", 0x35D, 11, FORM_RR, KIND_DP, 0 },
+    { "dfnms", 0x35E, 11, FORM_RR, KIND_DP, 0 }, { "dfnma", 0x35F, 11, FORM_RR, KIND_DP, 0 },
+    { "fesd", 0x3B8, 11, FORM_RR1, KIND_SP, 0 }, { "frds", 0x3B9, 11, FORM_RR1, KIND_DP, 0 },
+    { "ceq", 0x3C0, 11, FORM_RR, KIND_INT, 0 }, { "fceq", 0x3C2, 11, FORM_RR, KIND_SP, 0 },
+    { "mpy", 0x3C4, 11, FORM_RR, KIND_INT, 0 }, { "mpyh", 0x3C5, 11, FORM_RR, KIND_INT, 0 },
+    { "mpyhh", 0x3C6, 11, FORM_RR, KIND_INT, 0 }, { "mpys", 0x3C7, 11, FORM_RR, KIND_INT, 0 },
+    { "ceqh", 0x3C8, 11, FORM_RR, KIND_INT, 0 }, { "fcmeq", 0x3CA, 11, FORM_RR, KIND_SP, 0 },
+    { "mpyu", 0x3CC, 11, FORM_RR, KIND_INT, 0 }, { "mpyhhu", 0x3CE, 11, FORM_RR, KIND_INT, 0 },
+    { "ceqb", 0x3D0, 11, FORM_RR, KIND_INT, 0 },
+};
+const u32 NUM_INSNS = sizeof(insns) / sizeof(insns[0]);
+
+//--------------------------------------------------------------------------
+// Instruction encoding
+//--------------------------------------------------------------------------
+static u32 op(u32 opcode, int bits) { return opcode << (32 - bits); }
+
+static u32 rr(u32 opcode, u32 rt, u32 ra, u32 rb) { return op(opcode, 11) | rb << 14 | ra << 7 | rt; }
+static u32 rrr(u32 opcode, u32 rt, u32 ra, u32 rb, u32 rc) { return op(opcode, 4) | rt << 21 | rb << 14 | ra << 7 | rc; }
+static u32 ri7(u32 opcode, u32 rt, u32 ra, s32 i7) { return op(opcode, 11) | (i7 & 0x7F) << 14 | ra << 7 | rt; }
+static u32 ri10(u32 opcode, u32 rt, u32 ra, s32 i10) { return op(opcode, 8) | (i10 & 0x3FF) << 14 | ra << 7 | rt; }
+static u32 ri16(u32 opcode, u32 rt, s32 i16) { return op(opcode, 9) | (i16 & 0xFFFF) << 7 | rt; }
+
+//--------------------------------------------------------------------------
+// Test vectors
+//--------------------------------------------------------------------------
+struct Vector
+{
+    const InsnInfo *info;
+    u32 rt, ra, rb, rc;
+    s32 imm;
+    u32 word;
+    v128 in[4];      // ra, rb, rc sources (R10-R12) and the initial RT
+    v128 fpscrIn;
+    v128 expected;
+    v128 expectedFpscr;
+};
+
+static const u32 intEdges[] =
+{
+    0x00000000, 0x00000001, 0xFFFFFFFF, 0x7FFFFFFF, 0x80000000, 0x80000001,
+    0x0000FFFF, 0xFFFF0000, 0x00007FFF, 0x00008000, 0x0000007F, 0x00000080,
+    0x000000FF, 0x7FFF8000, 0x80007FFF, 0x01010101,
+};
+
+static u32 random_int(Rng &rng)
+{
+    switch (rng.below(4))
+    {
+    case 0: return (u32)((s32)rng.below(33) - 16);
+    case 1: return intEdges[rng.below(sizeof(intEdges) / sizeof(intEdges[0]))];
+    case 2: return rng.next32() >> rng.below(32);
+    default: return rng.next32();
+    }
+}
+
+// Zeros, denormals and exponent 255 (extended range on the SPU) show up a
+// lot more often than in uniform bits
+static u32 random_sp(Rng &rng)
+{
+    static const u32 exps[] = { 0, 1, 2, 103, 126, 127, 128, 152, 253, 254, 255 };
+    u32 sign = rng.next32() & 0x80000000;
+    u32 exp = rng.below(2) ? exps[rng.below(sizeof(exps) / sizeof(exps[0]))] : rng.below(256);
+    u32 mant;
+    switch (rng.below(4))
+    {
+    case 0: mant = 0; break;
+    case 1: mant = 1u << rng.below(23); break;
+    case 2: mant = 0x7FFFFF; break;
+    default: mant = rng.next32() & 0x7FFFFF; break;
+    }
+    return sign | exp << 23 | mant;
+}
+
+static u64 random_dp(Rng &rng)
+{
+    static const u64 exps[] = { 0, 1, 2, 0x3CA, 0x3FE, 0x3FF, 0x400, 0x434, 0x7FD, 0x7FE, 0x7FF };
+    const u64 quiet = 0x0008000000000000ULL, mantMask = 0x000FFFFFFFFFFFFFULL;
+    u64 sign = rng.next64() & 0x8000000000000000ULL;
+    u64 exp = rng.below(2) ? exps[rng.below(sizeof(exps) / sizeof(exps[0]))] : rng.below(0x800);
+    u64 mant;
+    switch (rng.below(5))
+    {
+    case 0: mant = 0; break;
+    case 1: mant = 1ULL << rng.below(52); break;
+    case 2: mant = quiet | (rng.next64() & mantMask); break;
+    case 3: mant = rng.next64() & mantMask & ~quiet; break;
+    default: mant = rng.next64() & mantMask; break;
+    }
+    return sign | exp << 52 | mant;
+}
+
+static v128 random_qword(Rng &rng, Kind kind)
+{
+    v128 r;
+    // the same value in every slot, like most real code has
+    bool splat = rng.below(4) == 0;
+    if (kind == KIND_DP && rng.below(8) != 0)
+    {
+        for (int i = 0; i < 2; ++i)
+            r.d(i) = splat && i ? r.d(0) : random_dp(rng);
+        return r;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        if (splat && i)
+            r.w(i) = r.w(0);
+        else if (kind == KIND_SP && rng.below(8) != 0)
+            r.w(i) = random_sp(rng);
+        else
+            r.w(i) = rng.below(8) ? random_int(rng) : random_sp(rng);
+    }
+    return r;
+}
+
+static s32 random_imm(Rng &rng, const InsnInfo &info)
+{
+    switch (info.form)
+    {
+    case FORM_RI7: return (s32)rng.below(128) - 64;
+    case FORM_RI8: return info.scaleBias - (s32)rng.below(128);
+    case FORM_RI10: return rng.below(2) ? (s32)rng.below(33) - 16 : (s32)rng.below(1024) - 512;
+    case FORM_RI16: return (s32)rng.below(0x10000);
+    case FORM_RI18: return (s32)rng.below(0x40000);
+    default: return 0;
+    }
+}
+
+static u32 encode(const Vector &v)
+{
+    const InsnInfo &info = *v.info;
+    u32 w = op(info.opcode, info.bits);
+    switch (info.form)
+    {
+    case FORM_RR: return w | v.rb << 14 | v.ra << 7 | v.rt;
+    case FORM_RR1: return w | v.ra << 7 | v.rt;
+    case FORM_RRR: return w | v.rt << 21 | v.rb << 14 | v.ra << 7 | v.rc;
+    case FORM_RI7: return w | (v.imm & 0x7F) << 14 | v.ra << 7 | v.rt;
+    case FORM_RI8: return w | (v.imm & 0xFF) << 14 | v.ra << 7 | v.rt;
+    case FORM_RI10: return w | (v.imm & 0x3FF) << 14 | v.ra << 7 | v.rt;
+    case FORM_RI16: return w | (v.imm & 0xFFFF) << 7 | v.rt;
+    case FORM_RI18: return w | (v.imm & 0x3FFFF) << 7 | v.rt;
+    }
+    return w;
+}
+
+static string disassemble(const Vector &v)
+{
+    const InsnInfo &info = *v.info;
+    char buf[64];
+    switch (info.form)
+    {
+    case FORM_RR: snprintf(buf, sizeof(buf), "%s $%u,$%u,$%u", info.name, v.rt, v.ra, v.rb); break;
+    case FORM_RR1: snprintf(buf, sizeof(buf), "%s $%u,$%u", info.name, v.rt, v.ra); break;
+    case FORM_RRR: snprintf(buf, sizeof(buf), "%s $%u,$%u,$%u,$%u", info.name, v.rt, v.ra, v.rb, v.rc); break;
+    case FORM_RI8: snprintf(buf, sizeof(buf), "%s $%u,$%u,%d", info.name, v.rt, v.ra, info.scaleBias - v.imm); break;
+    case FORM_RI7:
+    case FORM_RI10: snprintf(buf, sizeof(buf), "%s $%u,$%u,%d", info.name, v.rt, v.ra, v.imm); break;
+    case FORM_RI16:
+    case FORM_RI18: snprintf(buf, sizeof(buf), "%s $%u,0x%x", info.name, v.rt, v.imm); break;
+    }
+    return buf;
+}
+
+// Builds vector n and runs it on the reference for the expected values
+static Vector make_vector(u64 seed, u32 index, SpuInterpreter &spu)
+{
+    Rng rng(seed, index);
+    Vector v;
+    v.info = &insns[rng.below(NUM_INSNS)];
+    v.rt = R_RESULT;
+    v.ra = R_SRC + rng.below(3);
+    v.rb = R_SRC + rng.below(3);
+    v.rc = R_SRC + rng.below(3);
+    v.imm = random_imm(rng, *v.info);
+    v.word = encode(v);
+    for (int i = 0; i < 4; ++i)
+        v.in[i] = random_qword(rng, v.info->kind);
+    // rounding mode for both double slots, only double precision uses it
+    u32 mode = v.info->kind == KIND_DP ? (rng.next32() & 0xF) << 8 : 0;
+    v.fpscrIn = v128::from_words(mode, 0, 0, 0);
+
+    spu.reset();
+    for (int i = 0; i < 3; ++i)
+        spu.gpr[R_SRC + i] = v.in[i];
+    spu.gpr[R_RESULT] = v.in[3];
+    spu.gpr[R_FPSCR_IN] = v.fpscrIn;
+    spu.execute(rr(0x3BA, 0, R_FPSCR_IN, 0));   // fscrwr, same as the program
+    SpuInterpreter::RunResult r = spu.execute(v.word);
+    if (r != SpuInterpreter::RUN_OK)
+    {
+        printf("vector %u: %s (0x%08x) didn't run on the reference: %s\n", index,
+               disassemble(v).c_str(), v.word, spu.result_name(r));
+        exit(2);
+    }
+    v.expected = spu.gpr[R_RESULT];
+    v.expectedFpscr = spu.fpscr;
+    return v;
+}
+
+//--------------------------------------------------------------------------
+// Program generation, every word is encoded here so the same program can be
+// written out as assembly and run on the host directly
+//--------------------------------------------------------------------------
+struct Program
+{
+    vector<u32> words;
+    vector<string> comments;
+
+    u32 addr() const { return (u32)words.size() * 4; }
+    void emit(u32 word, const string &comment = "")
+    {
+        words.push_back(word);
+        comments.push_back(comment);
+    }
+    void emit_qword(const v128 &q, const string &comment)
+    {
+        for (int i = 0; i < 4; ++i)
+            emit(q.w(i), i == 0 ? comment : "");
+    }
+    // relative branch forms take a word offset from their own address
+    void patch_rel(u32 at, u32 target) { words[at / 4] |= (((target - at) >> 2) & 0xFFFF) << 7; }
+};
+
+static string fmt(const char *f, ...) __attribute__((format(printf, 1, 2)));
+static string fmt(const char *f, ...)
+{
+    char buf[128];
+    va_list ap;
+    va_start(ap, f);
+    vsnprintf(buf, sizeof(buf), f, ap);
+    va_end(ap);
+    return buf;
+}
+
+/*
+ * check: compares R3 with R8 and the FPSCR with R9, on a mismatch writes a
+ * record like cell-spu.s does (instruction word and address from the two
+ * words before R79) with the vector number from R7 in word 2. Clears the
+ * FPSCR and returns through R79
+ */
+static u32 emit_check(Program &p)
+{
+    u32 check = p.addr();
+    p.emit(rr(0x398, 75, 0, 0), "check: fscrrd $75");
+    p.emit(rr(0x3C0, 78, 3, 8), "ceq $78,$3,$8");
+    p.emit(rr(0x049, 77, 78, 78), "nor $77,$78,$78");
+    p.emit(rr(0x1F0, 76, 77, 0), "orx $76,$77");
+    u32 brFail = p.addr();
+    p.emit(ri16(0x042, 76, 0), "brnz $76,1f");
+    p.emit(rr(0x241, 76, 75, 9), "xor $76,$75,$9");
+    p.emit(rr(0x1F0, 76, 76, 0), "orx $76,$76");
+    u32 brPass = p.addr();
+    p.emit(ri16(0x040, 76, 0), "brz $76,0f");
+    p.patch_rel(brFail, p.addr());
+    p.emit(ri10(0x1C, 78, R_LINK, -8), "1: ai $78,$79,-8");
+    p.emit(ri10(0x34, 77, 78, 0), "lqd $77,0($78)");
+    p.emit(ri10(0x14, 76, 78, 0xF), "andi $76,$78,15");
+    p.emit(rr(0x1DF, 77, 77, 76), "shlqby $77,$77,$76");
+    p.emit(ri7(0x1F6, 76, R_RECORD, 4), "cwd $76,4($6)");
+    p.emit(rrr(0xB, 77, 78, 77, 76), "shufb $77,$78,$77,$76");
+    p.emit(ri7(0x1F6, 76, R_RECORD, 8), "cwd $76,8($6)");
+    p.emit(rrr(0xB, 77, R_INDEX, 77, 76), "shufb $77,$7,$77,$76");
+    p.emit(ri10(0x24, 77, R_RECORD, 0), "stqd $77,0($6)");
+    p.emit(ri10(0x24, 3, R_RECORD, 1), "stqd $3,16($6)");
+    p.emit(ri10(0x24, 8, R_RECORD, 2), "stqd $8,32($6)");
+    p.emit(ri10(0x24, 75, R_RECORD, 3), "stqd $75,48($6)");
+    p.emit(ri10(0x1C, R_RECORD, R_RECORD, 64), "ai $6,$6,64");
+    p.patch_rel(brPass, p.addr());
+    p.emit(ri16(0x081, 78, 0), "0: il $78,0");
+    p.emit(rr(0x3BA, 0, 78, 0), "fscrwr $78");
+    p.emit(rr(0x1A8, 0, R_LINK, 0), "bi $79");
+    return check;
+}
+
+const u32 VECTOR_WORDS = 12;
+const u32 POOL_QWORDS = 7;
+
+/*
+ * Same calling convention as cell-spu.s. Vectors come in blocks, the code
+ * of a block then a branch over its literal pool:
+ *   lqr $10-$12, $3, $13 (FPSCR in), $8, $9 (expected result and FPSCR)
+ *   ilhu/iohl $7 (vector number), fscrwr $13, the instruction, brsl check
+ */
+static void build_program(Program &p, const vector<Vector> &vecs, u32 first)
+{
+    p.emit(ri10(0x04, R_RECORD, 5, 0), "test: ori $6,$5,0");
+    u32 brStart = p.addr();
+    p.emit(ri16(0x064, 0, 0), "br start");
+    u32 check = emit_check(p);
+    p.patch_rel(brStart, p.addr());
+
+    for (u32 block = 0; block < vecs.size(); block += BLOCK_VECTORS)
+    {
+        u32 count = vecs.size() - block < BLOCK_VECTORS ? vecs.size() - block : BLOCK_VECTORS;
+        u32 codeEnd = p.addr() + (count * VECTOR_WORDS + 1) * 4;
+        u32 pool = (codeEnd + 15) & ~15;
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            const Vector &v = vecs[block + i];
+            u32 index = first + block + i;
+            u32 data = pool + i * POOL_QWORDS * 16;
+            static const u32 loads[POOL_QWORDS] = { R_SRC, R_SRC + 1, R_SRC + 2, R_RESULT, R_FPSCR_IN, R_EXPECT, R_EXPECT_FPSCR };
+            for (u32 q = 0; q < POOL_QWORDS; ++q)
+            {
+                u32 at = p.addr();
+                p.emit(ri16(0x067, loads[q], 0), q == 0 ? fmt("vector %u: lqr $%u,...", index, loads[q]) : fmt("lqr $%u,...", loads[q]));
+                p.patch_rel(at, data + q * 16);
+            }
+            p.emit(ri16(0x082, R_INDEX, index >> 16), fmt("ilhu $7,%u", index >> 16));
+            p.emit(ri16(0x0C1, R_INDEX, index & 0xFFFF), fmt("iohl $7,%u", index & 0xFFFF));
+            p.emit(rr(0x3BA, 0, R_FPSCR_IN, 0), "fscrwr $13");
+            p.emit(v.word, disassemble(v));
+            u32 at = p.addr();
+            p.emit(ri16(0x066, R_LINK, 0), "brsl $79,check");
+            p.patch_rel(at, check);
+        }
+
+        u32 brOver = p.addr();
+        p.emit(ri16(0x064, 0, 0), "br over the pool");
+        while (p.addr() < pool)
+            p.emit(0x00200000, "lnop");
+        for (u32 i = 0; i < count; ++i)
+        {
+            const Vector &v = vecs[block + i];
+            u32 index = first + block + i;
+            p.emit_qword(v.in[0], fmt("vector %u: $10", index));
+            p.emit_qword(v.in[1], "$11");
+            p.emit_qword(v.in[2], "$12");
+            p.emit_qword(v.in[3], "$3");
+            p.emit_qword(v.fpscrIn, "FPSCR in");
+            p.emit_qword(v.expected, "expected");
+            p.emit_qword(v.expectedFpscr, "expected FPSCR");
+        }
+        p.patch_rel(brOver, p.addr());
+    }
+
+    // number of records written
+    p.emit(rr(0x040, 3, 5, R_RECORD), "sf $3,$5,$6");
+    p.emit(ri7(0x079, 3, 3, -6), "rotmi $3,$3,-6");
+    p.emit(rr(0x1A8, 0, 0, 0), "bi $0");
+}
+
+static void write_program(FILE *f, const Program &p, u64 seed, u32 first, u32 count)
+{
+    fprintf(f, "# Generated by spu_fuzz -s %llu -f %u -n %u, do not edit.\n",
+            (unsigned long long)seed, first, count);
+    fprintf(f, "# Same interface and failure records as cell-spu.s, word 2 of a\n");
+    fprintf(f, "# record is the vector number for spu_fuzz -d.\n\n");
+    fprintf(f, "   .text\n   .global test\n   .balign 16\ntest:\n");
+    for (size_t i = 0; i < p.words.size(); ++i)
+    {
+        if (p.comments[i].empty())
+            fprintf(f, "   .int 0x%08x\n", p.words[i]);
+        else
+            fprintf(f, "   .int 0x%08x   # %s\n", p.words[i], p.comments[i].c_str());
+    }
+}
+
+//--------------------------------------------------------------------------
+// Records
+//--------------------------------------------------------------------------
+static u32 be32(const u8 *p) { return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+static void print_qword(const char *name, const v128 &q)
+{
+    printf("  %-14s 0x%08x 0x%08x 0x%08x 0x%08x\n", name, q.w(0), q.w(1), q.w(2), q.w(3));
+}
+
+static v128 record_qword(const u8 *p)
+{
+    return v128::from_words(be32(p), be32(p + 4), be32(p + 8), be32(p + 12));
+}
+
+// Prints a failure record with the operands of its vector
+static void decode_record(const u8 *rec, u64 seed, SpuInterpreter &spu)
+{
+    u32 word = be32(rec), addr = be32(rec + 4), index = be32(rec + 8);
+    Vector v = make_vector(seed, index, spu);
+    printf("----------------------------------------------------\n");
+    printf("vector %u at 0x%x: %s (0x%08x)\n", index, addr, disassemble(v).c_str(), v.word);
+    if (word != v.word)
+        printf("  record has instruction 0x%08x, wrong seed?\n", word);
+    print_qword("$10", v.in[0]);
+    print_qword("$11", v.in[1]);
+    print_qword("$12", v.in[2]);
+    print_qword("$3 before", v.in[3]);
+    print_qword("FPSCR in", v.fpscrIn);
+    print_qword("Output", record_qword(rec + 16));
+    print_qword("Expected", v.expected);
+    print_qword("FPSCR", record_qword(rec + 48));
+    print_qword("Expected FPSCR", v.expectedFpscr);
+}
+
+static int decode_file(const char *path, u64 seed)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        printf("failed to read %s\n", path);
+        return 2;
+    }
+    SpuInterpreter spu;
+    u8 rec[64];
+    int count = 0;
+    while (fread(rec, 1, sizeof(rec), f) == sizeof(rec))
+    {
+        decode_record(rec, seed, spu);
+        ++count;
+    }
+    fclose(f);
+    printf("%d records\n", count);
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// -x: runs the program on the reference, the way spu_host_runner calls test
+//--------------------------------------------------------------------------
+static int run_on_host(const Program &p, u64 seed, u32 count)
+{
+    SpuInterpreter spu;
+    for (size_t i = 0; i < p.words.size(); ++i)
+        spu.write_ls32(LOAD_ADDR + i * 4, p.words[i]);
+    spu.write_ls32(RETURN_ADDR, STOP_RETURN);
+    spu.pc = LOAD_ADDR;
+    spu.gpr[0] = v128::from_words(RETURN_ADDR, 0, 0, 0);
+    spu.gpr[1] = v128::from_words(STACK_TOP, STACK_TOP, 0, 0);
+    spu.gpr[4] = v128::from_words(SCRATCH_ADDR, 0, 0, 0);
+    spu.gpr[5] = v128::from_words(FAILURES_ADDR, 0, 0, 0);
+    spu.gpr[6] = v128::from_words(0, 1, 2, 4);
+
+    auto start = chrono::high_resolution_clock::now();
+    SpuInterpreter::RunResult r = spu.run();
+    double secs = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    if (r != SpuInterpreter::RUN_STOP || spu.stopCode != STOP_RETURN)
+    {
+        printf("spu stopped at 0x%x: %s (0x%08x)\n", spu.pc, spu.result_name(r), spu.read_ls32(spu.pc));
+        return 2;
+    }
+
+    int numFailed = (int)spu.gpr[3].w(0);
+    SpuInterpreter decoder;
+    for (int i = 0; i < numFailed && i < (int)MAX_VECTORS; ++i)
+        decode_record(spu.ls + FAILURES_ADDR + i * 64, seed, decoder);
+    printf("%u vectors, %d failed, %llu instructions in %.3f ms\n", count, numFailed,
+           (unsigned long long)spu.instructionCount, secs * 1000.0);
+    return numFailed == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    u64 seed = 1;
+    u32 first = 0, count = DEFAULT_VECTORS;
+    const char *outPath = NULL;
+    const char *recordsPath = NULL;
+    bool runHost = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            first = (u32)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            count = (u32)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            recordsPath = argv[++i];
+        else if (strcmp(argv[i], "-x") == 0)
+            runHost = true;
+        else
+        {
+            printf("usage: %s [-s seed] [-f first] [-n count] [-o out.s] [-x] [-d records.bin]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (recordsPath != NULL)
+        return decode_file(recordsPath, seed);
+    if (count == 0 || count > MAX_VECTORS)
+    {
+        printf("-n has to be 1 to %u, use -f to pick the next range\n", MAX_VECTORS);
+        return 2;
+    }
+
+    SpuInterpreter spu;
+    vector<Vector> vecs;
+    for (u32 i = 0; i < count; ++i)
+        vecs.push_back(make_vector(seed, first + i, spu));
+
+    Program p;
+    build_program(p, vecs, first);
+    if (LOAD_ADDR + p.addr() > RETURN_ADDR)
+    {
+        printf("program is 0x%x bytes, overlaps the runner buffers\n", p.addr());
+        return 2;
+    }
+    // -x alone only needs the host layout above
+    if ((outPath != NULL || !runHost) && p.addr() > RUNNER_MAX_PROGRAM)
+    {
+        printf("program is 0x%x bytes, more than the 0x%x that fit next to test_runner.spu.c, lower -n\n",
+               p.addr(), RUNNER_MAX_PROGRAM);
+        return 2;
+    }
+
+    if (outPath != NULL)
+    {
+        FILE *f = fopen(outPath, "w");
+        if (f == NULL)
+        {
+            printf("failed to write %s\n", outPath);
+            return 2;
+        }
+        write_program(f, p, seed, first, count);
+        fclose(f);
+    }
+    else if (!runHost)
+        write_program(stdout, p, seed, first, count);
+
+    return runHost ? run_on_host(p, seed, count) : 0;
+}
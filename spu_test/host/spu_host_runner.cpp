@@ -0,0 +1,217 @@
+// spu_host_runner.cpp : runs cell-spu.s on the host reference interpreter.
+//
+// Loads test_spu.spu.out (or any SPU elf with a global `test`), calls it the
+// same way test_runner.spu.c does and prints the same output, followed by
+// the instruction count and interpreter speed.
+//
+// usage: spu_host_runner [-o records.bin] test_spu.spu.out
+//
+
+#include "spu_interpreter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+// Local store layout, the stack is at the top like on lv2 and the buffers
+// test_runner.spu.c keeps on its stack sit right below it
+const u32 STACK_TOP = 0x3FFF0;
+const u32 FAILURES_ADDR = 0x2C000;   // 64KB
+const u32 SCRATCH_ADDR = 0x2A000;    // 8KB
+const u32 RETURN_ADDR = 0x29FF0;     // stop 0x102, `test` returns here
+const u32 STOP_RETURN = 0x102;
+
+const u32 EM_SPU = 23;
+const u32 PT_LOAD = 1;
+const u32 SHT_SYMTAB = 2;
+
+static u32 be32(const u8 *p) { return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static u16 be16(const u8 *p) { return (u16)((p[0] << 8) | p[1]); }
+
+static bool read_file(const char *path, vector<u8> &data)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data.resize(size);
+    bool ok = size > 0 && fread(&data[0], 1, size, f) == (size_t)size;
+    fclose(f);
+    return ok;
+}
+
+// Copies the PT_LOAD segments into local store and looks up `test`,
+// returns false with a message on anything unexpected
+static bool load_spu_elf(const vector<u8> &elf, SpuInterpreter &spu, u32 &entry, u32 &imageEnd)
+{
+    const u8 *p = &elf[0];
+    if (elf.size() < 52 || memcmp(p, "\x7F" "ELF", 4) != 0 || p[4] != 1 || p[5] != 2)
+    {
+        printf("not a 32 bit big endian elf\n");
+        return false;
+    }
+    if (be16(p + 18) != EM_SPU)
+    {
+        printf("not an spu elf (machine %d)\n", be16(p + 18));
+        return false;
+    }
+
+    u32 phoff = be32(p + 28), shoff = be32(p + 32);
+    u16 phentsize = be16(p + 42), phnum = be16(p + 44);
+    u16 shentsize = be16(p + 46), shnum = be16(p + 48);
+
+    imageEnd = 0;
+    for (u16 i = 0; i < phnum; ++i)
+    {
+        const u8 *ph = p + phoff + i * phentsize;
+        if (be32(ph) != PT_LOAD)
+            continue;
+        u32 offset = be32(ph + 4), vaddr = be32(ph + 8), filesz = be32(ph + 16), memsz = be32(ph + 20);
+        if (vaddr + memsz > SpuInterpreter::LS_SIZE || offset + filesz > elf.size())
+        {
+            printf("segment at 0x%x (0x%x bytes) doesn't fit in local store\n", vaddr, memsz);
+            return false;
+        }
+        memset(spu.ls + vaddr, 0, memsz);
+        memcpy(spu.ls + vaddr, p + offset, filesz);
+        if (vaddr + memsz > imageEnd)
+            imageEnd = vaddr + memsz;
+    }
+
+    for (u16 i = 0; i < shnum; ++i)
+    {
+        const u8 *sh = p + shoff + i * shentsize;
+        if (be32(sh + 4) != SHT_SYMTAB)
+            continue;
+        const u8 *strtab = p + be32(p + shoff + be32(sh + 24) * shentsize + 16);
+        u32 count = be32(sh + 20) / 16;
+        for (u32 s = 0; s < count; ++s)
+        {
+            const u8 *sym = p + be32(sh + 16) + s * 16;
+            if (strcmp((const char *)strtab + be32(sym), "test") == 0)
+            {
+                entry = be32(sym + 4);
+                return true;
+            }
+        }
+    }
+    printf("no `test` symbol, the elf needs its symbol table\n");
+    return false;
+}
+
+static void print_vec(const char *name, const u8 *p)
+{
+    printf("%s: 0x%x 0x%x 0x%x 0x%x\n", name, be32(p), be32(p + 4), be32(p + 8), be32(p + 12));
+}
+
+int main(int argc, char **argv)
+{
+    const char *elfPath = NULL;
+    const char *recordsPath = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            recordsPath = argv[++i];
+        else
+            elfPath = argv[i];
+    }
+    if (elfPath == NULL)
+    {
+        printf("usage: %s [-o records.bin] test_spu.spu.out\n", argv[0]);
+        return 2;
+    }
+
+    vector<u8> elf;
+    if (!read_file(elfPath, elf))
+    {
+        printf("failed to read %s\n", elfPath);
+        return 2;
+    }
+
+    SpuInterpreter spu;
+    u32 entry = 0, imageEnd = 0;
+    if (!load_spu_elf(elf, spu, entry, imageEnd))
+        return 2;
+    if (imageEnd > RETURN_ADDR)
+    {
+        printf("image ends at 0x%x, overlaps the runner buffers at 0x%x\n", imageEnd, RETURN_ADDR);
+        return 2;
+    }
+
+    spu.write_ls32(RETURN_ADDR, STOP_RETURN);
+    spu.pc = entry;
+    spu.gpr[0] = v128::from_words(RETURN_ADDR, 0, 0, 0);
+    spu.gpr[1] = v128::from_words(STACK_TOP, STACK_TOP, 0, 0);
+    spu.gpr[3] = v128::from_words(0, 0, 0, 0);
+    spu.gpr[4] = v128::from_words(SCRATCH_ADDR, 0, 0, 0);
+    spu.gpr[5] = v128::from_words(FAILURES_ADDR, 0, 0, 0);
+    spu.gpr[6] = v128::from_words(0, 1, 2, 4);
+
+    printf("Starting and running tests\n");
+
+    // Halts, invalid channels and stops are resumed the way cell-spu.s
+    // expects from its controlling code: the first scratch word tells the
+    // test what happened
+    auto start = chrono::high_resolution_clock::now();
+    for (;;)
+    {
+        SpuInterpreter::RunResult r = spu.run();
+        if (r == SpuInterpreter::RUN_STOP && spu.stopCode == STOP_RETURN && spu.pc == RETURN_ADDR + 4)
+            break;
+        if (r == SpuInterpreter::RUN_HALT || r == SpuInterpreter::RUN_INVALID_CHANNEL)
+            spu.write_ls32(SCRATCH_ADDR, 1);
+        else if (r == SpuInterpreter::RUN_STOP)
+            spu.write_ls32(SCRATCH_ADDR, spu.stopCode);
+        else
+        {
+            printf("spu stopped at 0x%x: %s (0x%08x)\n", spu.pc, spu.result_name(r), spu.read_ls32(spu.pc));
+            return 2;
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double secs = chrono::duration<double>(end - start).count();
+
+    int numFailed = (int)spu.gpr[3].w(0);
+    printf("done!\n");
+    if (numFailed == 0)
+        printf("No failed instructions detected\n");
+    else if (numFailed < 0)
+        printf("test failed to bootstrap itself.\n");
+    else
+    {
+        printf("%d failed instructions.\n", numFailed);
+        for (int i = 0; i < numFailed && i < 1024; ++i)
+        {
+            const u8 *rec = spu.ls + FAILURES_ADDR + i * 64;
+            printf("----------------------------------------------------\n");
+            printf("Failed Inst word: 0x%x. Addr: 0x%x\n", be32(rec), be32(rec + 4));
+            print_vec("Output", rec + 16);
+            print_vec("Expected", rec + 32);
+            print_vec("FPSCR", rec + 48);
+        }
+    }
+
+    printf("%llu instructions in %.3f ms (%.1f MIPS)\n", (unsigned long long)spu.instructionCount,
+           secs * 1000.0, secs > 0 ? spu.instructionCount / secs / 1e6 : 0.0);
+
+    // raw big endian records, the same bytes the spu side has in failedBuf
+    if (recordsPath != NULL && numFailed > 0)
+    {
+        FILE *f = fopen(recordsPath, "wb");
+        if (f == NULL)
+        {
+            printf("failed to write %s\n", recordsPath);
+            return 2;
+        }
+        fwrite(spu.ls + FAILURES_ADDR, 64, numFailed < 1024 ? numFailed : 1024, f);
+        fclose(f);
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,1303 @@
+// spu_interpreter.cpp : host side reference interpreter for the Cell SPU.
+//
+// Decoding goes through a 2048 entry table indexed by the top 11 bits of the
+// instruction word, shorter opcodes fill every entry they cover.
+//
+
+#include "spu_interpreter.h"
+
+#include <fenv.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned __int128 u128;
+
+static const int CONTINUE = -1;
+
+static inline u32 bswap32(u32 x) { return __builtin_bswap32(x); }
+static inline u64 bswap64(u64 x) { return __builtin_bswap64(x); }
+
+// Instruction fields
+static inline u32 f_rt(u32 op) { return op & 0x7F; }
+static inline u32 f_ra(u32 op) { return (op >> 7) & 0x7F; }
+static inline u32 f_rb(u32 op) { return (op >> 14) & 0x7F; }
+static inline u32 f_rt4(u32 op) { return (op >> 21) & 0x7F; }  // RRR form target
+static inline u32 f_rc(u32 op) { return op & 0x7F; }           // RRR form third source
+static inline s32 f_i7(u32 op) { return (s32)(op << 11) >> 25; }
+static inline u32 f_i8(u32 op) { return (op >> 14) & 0xFF; }
+static inline s32 f_i10(u32 op) { return (s32)(op << 8) >> 22; }
+static inline u32 f_i16(u32 op) { return (op >> 7) & 0xFFFF; }
+static inline s32 f_si16(u32 op) { return (s32)(op << 9) >> 16; }
+static inline u32 f_i18(u32 op) { return (op >> 7) & 0x3FFFF; }
+
+static inline u128 to_u128(const v128 &v) { return ((u128)v._u64[1] << 64) | v._u64[0]; }
+static inline v128 from_u128(u128 x)
+{
+    v128 r;
+    r._u64[1] = (u64)(x >> 64);
+    r._u64[0] = (u64)x;
+    return r;
+}
+
+// Single precision, SPU style: no Inf/NaN/denormals, exponent 255 is a
+// normal exponent, results are truncated. Values go through a double, which
+// holds any SPU single (and any product of two) exactly, with the host in
+// round towards zero so the double rounding can't round up.
+static double sp_value(u32 x, u32 &flags)
+{
+    u32 exp = (x >> 23) & 0xFF;
+    if (exp == 0)
+    {
+        if (x & 0x7FFFFF)
+            flags |= FPSCR_SDIFF;
+        return (x & 0x80000000) ? -0.0 : 0.0;
+    }
+    if (exp == 255)
+        flags |= FPSCR_SDIFF;
+    double v = ldexp((double)((x & 0x7FFFFF) | 0x800000), (int)exp - 150);
+    return (x & 0x80000000) ? -v : v;
+}
+
+static u32 sp_result(double v, u32 &flags)
+{
+    if (v == 0.0)
+        return 0;  // zero results are always positive
+    u32 sign = v < 0.0 ? 0x80000000 : 0;
+    int e;
+    double m = frexp(fabs(v), &e);
+    int exp = e - 1 + 127;
+    if (exp > 255)
+    {
+        flags |= FPSCR_SOVF | FPSCR_SDIFF;
+        return sign | 0x7FFFFFFF;
+    }
+    if (exp < 1)
+    {
+        flags |= FPSCR_SUNF | FPSCR_SDIFF;
+        return 0;
+    }
+    if (exp == 255)
+        flags |= FPSCR_SDIFF;
+    return sign | ((u32)exp << 23) | ((u32)ldexp(m, 24) & 0x7FFFFF);
+}
+
+// Double precision, IEEE with per slot rounding mode, denormal inputs read
+// as zero and a fixed default NaN
+static const int dpRounding[4] = { FE_TONEAREST, FE_TOWARDZERO, FE_UPWARD, FE_DOWNWARD };
+static const u64 DP_DEFAULT_NAN = 0x7FF8000000000000ULL;
+
+static inline bool dp_is_nan(u64 x) { return (x & 0x7FFFFFFFFFFFFFFFULL) > 0x7FF0000000000000ULL; }
+static inline bool dp_is_snan(u64 x) { return dp_is_nan(x) && !(x & 0x0008000000000000ULL); }
+
+static double dp_value(u64 x, u32 &flags)
+{
+    if ((x & 0x7FF0000000000000ULL) == 0 && (x & 0x000FFFFFFFFFFFFFULL))
+    {
+        flags |= FPSCR_DDENORM;
+        x &= 0x8000000000000000ULL;
+    }
+    double d;
+    memcpy(&d, &x, sizeof(d));
+    return d;
+}
+
+static inline u64 dp_bits(double d)
+{
+    u64 x;
+    memcpy(&x, &d, sizeof(x));
+    return x;
+}
+
+static u32 host_flags_to_dp()
+{
+    u32 flags = 0;
+    if (fetestexcept(FE_OVERFLOW))
+        flags |= FPSCR_DOVF;
+    if (fetestexcept(FE_UNDERFLOW))
+        flags |= FPSCR_DUNF;
+    if (fetestexcept(FE_INEXACT))
+        flags |= FPSCR_DINX;
+    return flags;
+}
+
+enum { DF_ADD, DF_SUB, DF_MUL, DF_MA, DF_MS, DF_NMS, DF_NMA };
+
+static u64 dp_arith(int kind, u64 xa, u64 xb, u64 xc, int mode, u32 &flags)
+{
+    bool three = kind >= DF_MA;
+    double a = dp_value(xa, flags);
+    double b = dp_value(xb, flags);
+    double c = three ? dp_value(xc, flags) : 0.0;
+
+    bool nan = dp_is_nan(xa) || dp_is_nan(xb) || (three && dp_is_nan(xc));
+    bool invalid = dp_is_snan(xa) || dp_is_snan(xb) || (three && dp_is_snan(xc));
+
+    if (kind >= DF_MUL && ((a == 0.0 && isinf(b)) || (isinf(a) && b == 0.0)))
+        invalid = true;
+    else if (!nan)
+    {
+        // inf - inf, in the add or in the accumulate step
+        double x = a, y = b;
+        if (kind == DF_SUB)
+            y = -b;
+        else if (three)
+        {
+            x = a * b;
+            y = (kind == DF_MS || kind == DF_NMS) ? -c : c;
+        }
+        if (kind != DF_MUL && isinf(x) && isinf(y) && signbit(x) != signbit(y))
+            invalid = true;
+    }
+
+    if (nan || invalid)
+    {
+        flags |= (nan ? FPSCR_DNAN : 0) | (invalid ? FPSCR_DINV : 0);
+        return DP_DEFAULT_NAN;
+    }
+
+    fesetround(dpRounding[mode]);
+    feclearexcept(FE_ALL_EXCEPT);
+    volatile double r;
+    switch (kind)
+    {
+    case DF_ADD: r = a + b; break;
+    case DF_SUB: r = a - b; break;
+    case DF_MUL: r = a * b; break;
+    case DF_MA: r = fma(a, b, c); break;
+    case DF_MS: r = fma(a, b, -c); break;
+    case DF_NMS: r = -fma(a, b, -c); break;
+    default: r = -fma(a, b, c); break;
+    }
+    flags |= host_flags_to_dp();
+    fesetround(FE_TOWARDZERO);
+    return dp_bits(r);
+}
+
+struct SpuOps
+{
+    typedef SpuInterpreter Spu;
+
+    static inline int dp_mode(const Spu &spu, int slot) { return (spu.fpscr.w(0) >> (10 - slot * 2)) & 3; }
+
+    //----------------------------------------------------------------------
+    // Memory - load/store
+    //----------------------------------------------------------------------
+    static int lqd(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.read_ls128(spu.gpr[f_ra(op)].w(0) + (f_i10(op) << 4));
+        return CONTINUE;
+    }
+    static int lqx(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.read_ls128(spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0));
+        return CONTINUE;
+    }
+    static int lqa(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.read_ls128(f_si16(op) << 2);
+        return CONTINUE;
+    }
+    static int lqr(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.read_ls128(spu.pc + (f_si16(op) << 2));
+        return CONTINUE;
+    }
+    static int stqd(Spu &spu, u32 op)
+    {
+        spu.write_ls128(spu.gpr[f_ra(op)].w(0) + (f_i10(op) << 4), spu.gpr[f_rt(op)]);
+        return CONTINUE;
+    }
+    static int stqx(Spu &spu, u32 op)
+    {
+        spu.write_ls128(spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0), spu.gpr[f_rt(op)]);
+        return CONTINUE;
+    }
+    static int stqa(Spu &spu, u32 op)
+    {
+        spu.write_ls128(f_si16(op) << 2, spu.gpr[f_rt(op)]);
+        return CONTINUE;
+    }
+    static int stqr(Spu &spu, u32 op)
+    {
+        spu.write_ls128(spu.pc + (f_si16(op) << 2), spu.gpr[f_rt(op)]);
+        return CONTINUE;
+    }
+
+    // Generate controls for insertion, the base pattern selects the second
+    // shufb operand unchanged
+    static v128 insert_mask(u32 pos, u32 size)
+    {
+        v128 r;
+        for (int i = 0; i < 16; ++i)
+            r.b(i) = 0x10 + i;
+        for (u32 i = 0; i < size; ++i)
+            r.b(pos + i) = (u8)(i + (size < 4 ? 4 - size : 0));
+        return r;
+    }
+    static int cbd(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + f_i7(op)) & 0xF, 1); return CONTINUE; }
+    static int chd(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + f_i7(op)) & 0xE, 2); return CONTINUE; }
+    static int cwd(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + f_i7(op)) & 0xC, 4); return CONTINUE; }
+    static int cdd(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + f_i7(op)) & 0x8, 8); return CONTINUE; }
+    static int cbx(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0)) & 0xF, 1); return CONTINUE; }
+    static int chx(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0)) & 0xE, 2); return CONTINUE; }
+    static int cwx(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0)) & 0xC, 4); return CONTINUE; }
+    static int cdx(Spu &spu, u32 op) { spu.gpr[f_rt(op)] = insert_mask((spu.gpr[f_ra(op)].w(0) + spu.gpr[f_rb(op)].w(0)) & 0x8, 8); return CONTINUE; }
+
+    //----------------------------------------------------------------------
+    // Constant formation
+    //----------------------------------------------------------------------
+    static int ilh(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 8; ++i)
+            rt._u16[i] = (u16)f_i16(op);
+        return CONTINUE;
+    }
+    static int ilhu(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+            rt._u32[i] = f_i16(op) << 16;
+        return CONTINUE;
+    }
+    static int il(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+            rt._u32[i] = (u32)f_si16(op);
+        return CONTINUE;
+    }
+    static int ila(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+            rt._u32[i] = f_i18(op);
+        return CONTINUE;
+    }
+    static int iohl(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+            rt._u32[i] |= f_i16(op);
+        return CONTINUE;
+    }
+    static int fsmbi(Spu &spu, u32 op)
+    {
+        v128 &rt = spu.gpr[f_rt(op)];
+        u32 imm = f_i16(op);
+        for (int i = 0; i < 16; ++i)
+            rt.b(i) = (imm & (0x8000 >> i)) ? 0xFF : 0x00;
+        return CONTINUE;
+    }
+
+    //----------------------------------------------------------------------
+    // Integer and logical
+    //----------------------------------------------------------------------
+#define WORD_OP(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        (void)a; (void)b; \
+        for (int i = 0; i < 4; ++i) \
+        { \
+            u32 ra = a._u32[i], rb = b._u32[i], rt = t._u32[i]; \
+            (void)ra; (void)rb; (void)rt; \
+            t._u32[i] = (expr); \
+        } \
+        return CONTINUE; \
+    }
+#define HALF_OP(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        (void)a; (void)b; \
+        for (int i = 0; i < 8; ++i) \
+        { \
+            u16 ra = a._u16[i], rb = b._u16[i]; \
+            (void)ra; (void)rb; \
+            t._u16[i] = (u16)(expr); \
+        } \
+        return CONTINUE; \
+    }
+#define BYTE_OP(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        (void)a; (void)b; \
+        for (int i = 0; i < 16; ++i) \
+        { \
+            u8 ra = a._u8[i], rb = b._u8[i]; \
+            (void)ra; (void)rb; \
+            t._u8[i] = (u8)(expr); \
+        } \
+        return CONTINUE; \
+    }
+
+#define I10 ((u32)f_i10(op))
+#define I10H ((u16)f_i10(op))
+#define I10B ((u8)(f_i10(op) & 0xFF))
+
+    HALF_OP(ah, ra + rb)
+    HALF_OP(ahi, ra + I10H)
+    WORD_OP(a, ra + rb)
+    WORD_OP(ai, ra + I10)
+    HALF_OP(sfh, rb - ra)
+    HALF_OP(sfhi, I10H - ra)
+    WORD_OP(sf, rb - ra)
+    WORD_OP(sfi, I10 - ra)
+    WORD_OP(addx, ra + rb + (rt & 1))
+    WORD_OP(cg, (u32)(((u64)ra + rb) >> 32))
+    WORD_OP(cgx, (u32)(((u64)ra + rb + (rt & 1)) >> 32))
+    WORD_OP(sfx, rb + ~ra + (rt & 1))
+    WORD_OP(bg, rb >= ra ? 1 : 0)
+    WORD_OP(bgx, (u32)(((u64)rb + (u32)~ra + (rt & 1)) >> 32))
+    WORD_OP(mpy, (u32)((s32)(s16)ra * (s16)rb))
+    WORD_OP(mpyu, (u32)(u16)ra * (u16)rb)
+    WORD_OP(mpyi, (u32)((s32)(s16)ra * (s32)(s16)I10))
+    WORD_OP(mpyui, (u32)(u16)ra * (u16)I10)
+    WORD_OP(mpyh, ((ra >> 16) * (rb & 0xFFFF)) << 16)
+    WORD_OP(mpys, (u32)(((s32)(s16)ra * (s16)rb) >> 16))
+    WORD_OP(mpyhh, (u32)((s32)(s16)(ra >> 16) * (s16)(rb >> 16)))
+    WORD_OP(mpyhha, rt + (u32)((s32)(s16)(ra >> 16) * (s16)(rb >> 16)))
+    WORD_OP(mpyhhu, (ra >> 16) * (rb >> 16))
+    WORD_OP(mpyhhau, rt + (ra >> 16) * (rb >> 16))
+
+    static int mpya(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)], c = spu.gpr[f_rc(op)];
+        v128 &t = spu.gpr[f_rt4(op)];
+        for (int i = 0; i < 4; ++i)
+            t._u32[i] = (u32)((s32)(s16)a._u32[i] * (s16)b._u32[i]) + c._u32[i];
+        return CONTINUE;
+    }
+
+    WORD_OP(clz, ra ? __builtin_clz(ra) : 32)
+    BYTE_OP(cntb, __builtin_popcount(ra))
+    BYTE_OP(avgb, (ra + rb + 1) >> 1)
+    BYTE_OP(absdb, ra > rb ? ra - rb : rb - ra)
+
+    static int fsmb(Spu &spu, u32 op)
+    {
+        u32 bits = spu.gpr[f_ra(op)].w(0);
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 16; ++i)
+            t.b(i) = (bits & (0x8000 >> i)) ? 0xFF : 0;
+        return CONTINUE;
+    }
+    static int fsmh(Spu &spu, u32 op)
+    {
+        u32 bits = spu.gpr[f_ra(op)].w(0);
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 8; ++i)
+            t.h(i) = (bits & (0x80 >> i)) ? 0xFFFF : 0;
+        return CONTINUE;
+    }
+    static int fsm(Spu &spu, u32 op)
+    {
+        u32 bits = spu.gpr[f_ra(op)].w(0);
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+            t.w(i) = (bits & (0x8 >> i)) ? 0xFFFFFFFF : 0;
+        return CONTINUE;
+    }
+    static int gbb(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        u32 bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits = (bits << 1) | (a.b(i) & 1);
+        spu.gpr[f_rt(op)] = v128::from_words(bits, 0, 0, 0);
+        return CONTINUE;
+    }
+    static int gbh(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        u32 bits = 0;
+        for (int i = 0; i < 8; ++i)
+            bits = (bits << 1) | (a.h(i) & 1);
+        spu.gpr[f_rt(op)] = v128::from_words(bits, 0, 0, 0);
+        return CONTINUE;
+    }
+    static int gb(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        u32 bits = 0;
+        for (int i = 0; i < 4; ++i)
+            bits = (bits << 1) | (a.w(i) & 1);
+        spu.gpr[f_rt(op)] = v128::from_words(bits, 0, 0, 0);
+        return CONTINUE;
+    }
+    static int sumb(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 sa = 0, sb = 0;
+            for (int j = 0; j < 4; ++j)
+            {
+                sa += a.b(i * 4 + j);
+                sb += b.b(i * 4 + j);
+            }
+            t.h(i * 2) = (u16)sb;
+            t.h(i * 2 + 1) = (u16)sa;
+        }
+        return CONTINUE;
+    }
+    HALF_OP(xsbh, (s16)(s8)ra)
+    WORD_OP(xshw, (u32)(s32)(s16)ra)
+    static int xswd(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 2; ++i)
+            t._u64[i] = (u64)(s64)(s32)a._u64[i];
+        return CONTINUE;
+    }
+
+    WORD_OP(and_, ra & rb)
+    WORD_OP(andc, ra & ~rb)
+    BYTE_OP(andbi, ra & I10B)
+    HALF_OP(andhi, ra & I10H)
+    WORD_OP(andi, ra & I10)
+    WORD_OP(or_, ra | rb)
+    WORD_OP(orc, ra | ~rb)
+    BYTE_OP(orbi, ra | I10B)
+    HALF_OP(orhi, ra | I10H)
+    WORD_OP(ori, ra | I10)
+    WORD_OP(xor_, ra ^ rb)
+    BYTE_OP(xorbi, ra ^ I10B)
+    HALF_OP(xorhi, ra ^ I10H)
+    WORD_OP(xori, ra ^ I10)
+    WORD_OP(nand, ~(ra & rb))
+    WORD_OP(nor, ~(ra | rb))
+    WORD_OP(eqv, ~(ra ^ rb))
+
+    static int orx(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        spu.gpr[f_rt(op)] = v128::from_words(a._u32[0] | a._u32[1] | a._u32[2] | a._u32[3], 0, 0, 0);
+        return CONTINUE;
+    }
+    static int selb(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)], c = spu.gpr[f_rc(op)];
+        v128 &t = spu.gpr[f_rt4(op)];
+        for (int i = 0; i < 2; ++i)
+            t._u64[i] = (c._u64[i] & b._u64[i]) | (~c._u64[i] & a._u64[i]);
+        return CONTINUE;
+    }
+    static int shufb(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)], c = spu.gpr[f_rc(op)];
+        v128 &t = spu.gpr[f_rt4(op)];
+        for (int i = 0; i < 16; ++i)
+        {
+            u8 sel = c.b(i);
+            if ((sel & 0xC0) == 0x80)
+                t.b(i) = 0x00;
+            else if ((sel & 0xE0) == 0xC0)
+                t.b(i) = 0xFF;
+            else if ((sel & 0xE0) == 0xE0)
+                t.b(i) = 0x80;
+            else
+                t.b(i) = (sel & 0x10) ? b.b(sel & 0xF) : a.b(sel & 0xF);
+        }
+        return CONTINUE;
+    }
+
+    //----------------------------------------------------------------------
+    // Shift and rotate
+    //----------------------------------------------------------------------
+#define SH_HALF(name, count, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        (void)b; \
+        for (int i = 0; i < 8; ++i) \
+        { \
+            u32 ra = a._u16[i], s = (count); \
+            t._u16[i] = (u16)(expr); \
+        } \
+        return CONTINUE; \
+    }
+#define SH_WORD(name, count, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 a = spu.gpr[f_ra(op)], b = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        (void)b; \
+        for (int i = 0; i < 4; ++i) \
+        { \
+            u32 ra = a._u32[i], s = (count); \
+            t._u32[i] = (u32)(expr); \
+        } \
+        return CONTINUE; \
+    }
+
+    SH_HALF(shlh, b._u16[i] & 0x1F, s > 15 ? 0 : ra << s)
+    SH_HALF(shlhi, f_i7(op) & 0x1F, s > 15 ? 0 : ra << s)
+    SH_WORD(shl, b._u32[i] & 0x3F, s > 31 ? 0 : (u64)ra << s)
+    SH_WORD(shli, f_i7(op) & 0x3F, s > 31 ? 0 : (u64)ra << s)
+    SH_HALF(roth, b._u16[i] & 0xF, (ra << s) | (ra >> (16 - s)))
+    SH_HALF(rothi, f_i7(op) & 0xF, (ra << s) | (ra >> (16 - s)))
+    SH_WORD(rot, b._u32[i] & 0x1F, s ? (ra << s) | (ra >> (32 - s)) : ra)
+    SH_WORD(roti, f_i7(op) & 0x1F, s ? (ra << s) | (ra >> (32 - s)) : ra)
+    SH_HALF(rothm, (0 - b._u16[i]) & 0x1F, s > 15 ? 0 : ra >> s)
+    SH_HALF(rothmi, (0 - f_i7(op)) & 0x1F, s > 15 ? 0 : ra >> s)
+    SH_WORD(rotm, (0 - b._u32[i]) & 0x3F, s > 31 ? 0 : ra >> s)
+    SH_WORD(rotmi, (0 - f_i7(op)) & 0x3F, s > 31 ? 0 : ra >> s)
+    SH_HALF(rotmah, (0 - b._u16[i]) & 0x1F, (s16)ra >> (s > 15 ? 15 : s))
+    SH_HALF(rotmahi, (0 - f_i7(op)) & 0x1F, (s16)ra >> (s > 15 ? 15 : s))
+    SH_WORD(rotma, (0 - b._u32[i]) & 0x3F, (s32)ra >> (s > 31 ? 31 : s))
+    SH_WORD(rotmai, (0 - f_i7(op)) & 0x3F, (s32)ra >> (s > 31 ? 31 : s))
+
+    // Quadword forms, shift counts come from the preferred word of RB
+    static inline u128 qrot(u128 x, u32 bits) { return bits ? (x << bits) | (x >> (128 - bits)) : x; }
+    static inline u128 qshl(u128 x, u32 bits) { return bits > 127 ? 0 : x << bits; }
+    static inline u128 qshr(u128 x, u32 bits) { return bits > 127 ? 0 : x >> bits; }
+
+#define SH_QUAD(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        u128 x = to_u128(spu.gpr[f_ra(op)]); \
+        u32 rb = spu.gpr[f_rb(op)].w(0); \
+        (void)rb; \
+        spu.gpr[f_rt(op)] = from_u128(expr); \
+        return CONTINUE; \
+    }
+
+    SH_QUAD(shlqbi, qshl(x, rb & 7))
+    SH_QUAD(shlqbii, qshl(x, f_i7(op) & 7))
+    SH_QUAD(shlqby, qshl(x, (rb & 0x1F) * 8))
+    SH_QUAD(shlqbyi, qshl(x, (f_i7(op) & 0x1F) * 8))
+    SH_QUAD(shlqbybi, qshl(x, ((rb >> 3) & 0x1F) * 8))
+    SH_QUAD(rotqbi, qrot(x, rb & 7))
+    SH_QUAD(rotqbii, qrot(x, f_i7(op) & 7))
+    SH_QUAD(rotqby, qrot(x, (rb & 0xF) * 8))
+    SH_QUAD(rotqbyi, qrot(x, (f_i7(op) & 0xF) * 8))
+    SH_QUAD(rotqbybi, qrot(x, ((rb >> 3) & 0xF) * 8))
+    SH_QUAD(rotqmbi, qshr(x, (0 - rb) & 7))
+    SH_QUAD(rotqmbii, qshr(x, (0 - f_i7(op)) & 7))
+    SH_QUAD(rotqmby, qshr(x, ((0 - rb) & 0x1F) * 8))
+    SH_QUAD(rotqmbyi, qshr(x, ((0 - f_i7(op)) & 0x1F) * 8))
+    SH_QUAD(rotqmbybi, qshr(x, ((0 - (rb >> 3)) & 0x1F) * 8))
+
+    //----------------------------------------------------------------------
+    // Compare, branch and halt
+    //----------------------------------------------------------------------
+    WORD_OP(ceq, ra == rb ? 0xFFFFFFFF : 0)
+    WORD_OP(ceqi, ra == I10 ? 0xFFFFFFFF : 0)
+    HALF_OP(ceqh, ra == rb ? 0xFFFF : 0)
+    HALF_OP(ceqhi, ra == I10H ? 0xFFFF : 0)
+    BYTE_OP(ceqb, ra == rb ? 0xFF : 0)
+    BYTE_OP(ceqbi, ra == I10B ? 0xFF : 0)
+    WORD_OP(cgt, (s32)ra > (s32)rb ? 0xFFFFFFFF : 0)
+    WORD_OP(cgti, (s32)ra > (s32)I10 ? 0xFFFFFFFF : 0)
+    HALF_OP(cgth, (s16)ra > (s16)rb ? 0xFFFF : 0)
+    HALF_OP(cgthi, (s16)ra > (s16)I10H ? 0xFFFF : 0)
+    BYTE_OP(cgtb, (s8)ra > (s8)rb ? 0xFF : 0)
+    BYTE_OP(cgtbi, (s8)ra > (s8)I10B ? 0xFF : 0)
+    WORD_OP(clgt, ra > rb ? 0xFFFFFFFF : 0)
+    WORD_OP(clgti, ra > I10 ? 0xFFFFFFFF : 0)
+    HALF_OP(clgth, ra > rb ? 0xFFFF : 0)
+    HALF_OP(clgthi, ra > I10H ? 0xFFFF : 0)
+    BYTE_OP(clgtb, ra > rb ? 0xFF : 0)
+    BYTE_OP(clgtbi, ra > I10B ? 0xFF : 0)
+
+    static int halt_if(bool cond) { return cond ? Spu::RUN_HALT : CONTINUE; }
+    static int heq(Spu &spu, u32 op) { return halt_if(spu.gpr[f_ra(op)].w(0) == spu.gpr[f_rb(op)].w(0)); }
+    static int heqi(Spu &spu, u32 op) { return halt_if(spu.gpr[f_ra(op)].w(0) == (u32)f_i10(op)); }
+    static int hgt(Spu &spu, u32 op) { return halt_if((s32)spu.gpr[f_ra(op)].w(0) > (s32)spu.gpr[f_rb(op)].w(0)); }
+    static int hgti(Spu &spu, u32 op) { return halt_if((s32)spu.gpr[f_ra(op)].w(0) > f_i10(op)); }
+    static int hlgt(Spu &spu, u32 op) { return halt_if(spu.gpr[f_ra(op)].w(0) > spu.gpr[f_rb(op)].w(0)); }
+    static int hlgti(Spu &spu, u32 op) { return halt_if(spu.gpr[f_ra(op)].w(0) > (u32)f_i10(op)); }
+
+    static inline void link(Spu &spu, u32 rt) { spu.gpr[rt] = v128::from_words((spu.pc + 4) & (Spu::LS_SIZE - 1), 0, 0, 0); }
+    static inline void branch_rel(Spu &spu, u32 op) { spu.npc = (spu.pc + (f_si16(op) << 2)) & (Spu::LS_SIZE - 1); }
+    static inline void branch_ind(Spu &spu, u32 target) { spu.npc = target & (Spu::LS_SIZE - 1) & ~3; }
+
+    static int br(Spu &spu, u32 op) { branch_rel(spu, op); return CONTINUE; }
+    static int bra(Spu &spu, u32 op) { branch_ind(spu, f_si16(op) << 2); return CONTINUE; }
+    static int brsl(Spu &spu, u32 op) { link(spu, f_rt(op)); branch_rel(spu, op); return CONTINUE; }
+    static int brasl(Spu &spu, u32 op) { link(spu, f_rt(op)); branch_ind(spu, f_si16(op) << 2); return CONTINUE; }
+    static int brz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].w(0) == 0) branch_rel(spu, op); return CONTINUE; }
+    static int brnz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].w(0) != 0) branch_rel(spu, op); return CONTINUE; }
+    static int brhz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].h(1) == 0) branch_rel(spu, op); return CONTINUE; }
+    static int brhnz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].h(1) != 0) branch_rel(spu, op); return CONTINUE; }
+    static int bi(Spu &spu, u32 op) { branch_ind(spu, spu.gpr[f_ra(op)].w(0)); return CONTINUE; }
+    static int iret(Spu &spu, u32 op) { (void)op; branch_ind(spu, spu.srr0); return CONTINUE; }
+    static int bisl(Spu &spu, u32 op)
+    {
+        u32 target = spu.gpr[f_ra(op)].w(0);
+        link(spu, f_rt(op));
+        branch_ind(spu, target);
+        return CONTINUE;
+    }
+    // No interrupts on the host, so the condition is just a pending event
+    static int bisled(Spu &spu, u32 op)
+    {
+        u32 target = spu.gpr[f_ra(op)].w(0);
+        link(spu, f_rt(op));
+        if (spu.eventStat & spu.eventMask)
+            branch_ind(spu, target);
+        return CONTINUE;
+    }
+    static int biz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].w(0) == 0) branch_ind(spu, spu.gpr[f_ra(op)].w(0)); return CONTINUE; }
+    static int binz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].w(0) != 0) branch_ind(spu, spu.gpr[f_ra(op)].w(0)); return CONTINUE; }
+    static int bihz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].h(1) == 0) branch_ind(spu, spu.gpr[f_ra(op)].w(0)); return CONTINUE; }
+    static int bihnz(Spu &spu, u32 op) { if (spu.gpr[f_rt(op)].h(1) != 0) branch_ind(spu, spu.gpr[f_ra(op)].w(0)); return CONTINUE; }
+
+    // hbr*, nop, lnop, sync, dsync have no visible effect
+    static int nop(Spu &spu, u32 op) { (void)spu; (void)op; return CONTINUE; }
+
+    //----------------------------------------------------------------------
+    // Floating point
+    //----------------------------------------------------------------------
+#define SP_OP(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 xa = spu.gpr[f_ra(op)], xb = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        for (int i = 0; i < 4; ++i) \
+        { \
+            u32 flags = 0; \
+            double a = sp_value(xa.w(i), flags), b = sp_value(xb.w(i), flags); \
+            t.w(i) = sp_result(expr, flags); \
+            spu.fpscr.w(i) |= flags; \
+        } \
+        return CONTINUE; \
+    }
+#define SP_OP3(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 xa = spu.gpr[f_ra(op)], xb = spu.gpr[f_rb(op)], xc = spu.gpr[f_rc(op)]; \
+        v128 &t = spu.gpr[f_rt4(op)]; \
+        for (int i = 0; i < 4; ++i) \
+        { \
+            u32 flags = 0; \
+            double a = sp_value(xa.w(i), flags), b = sp_value(xb.w(i), flags); \
+            double c = sp_value(xc.w(i), flags); \
+            t.w(i) = sp_result(expr, flags); \
+            spu.fpscr.w(i) |= flags; \
+        } \
+        return CONTINUE; \
+    }
+
+    SP_OP(fa, a + b)
+    SP_OP(fs, a - b)
+    SP_OP(fm, a * b)
+    SP_OP3(fma_, fma(a, b, c))
+    SP_OP3(fms, fma(a, b, -c))
+    SP_OP3(fnms, fma(-a, b, c))
+
+    // Comparisons never set flags
+#define SP_CMP(name, expr) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 xa = spu.gpr[f_ra(op)], xb = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        for (int i = 0; i < 4; ++i) \
+        { \
+            u32 flags = 0; \
+            double a = sp_value(xa.w(i), flags), b = sp_value(xb.w(i), flags); \
+            t.w(i) = (expr) ? 0xFFFFFFFF : 0; \
+        } \
+        return CONTINUE; \
+    }
+
+    SP_CMP(fceq, a == b)
+    SP_CMP(fcmeq, fabs(a) == fabs(b))
+    SP_CMP(fcgt, a > b)
+    SP_CMP(fcmgt, fabs(a) > fabs(b))
+
+    // Reciprocal estimates: the result is exact and fi passes it through,
+    // which cell-spu.s accepts in place of the hardware's table lookup.
+    // Zero (and denormal) inputs give the largest magnitude and DBZ.
+    static u32 sp_estimate(double v)
+    {
+        u32 ignored = 0;
+        u32 r = sp_result(v, ignored);
+        return r;
+    }
+    static int frest(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 x = xa.w(i), ignored = 0;
+            if ((x & 0x7F800000) == 0)
+            {
+                spu.fpscr.w(3) |= 0x800 >> i;
+                t.w(i) = (x & 0x80000000) | 0x7FFFFFFF;
+            }
+            else
+                t.w(i) = sp_estimate(1.0 / sp_value(x, ignored));
+        }
+        return CONTINUE;
+    }
+    static int frsqest(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 x = xa.w(i) & 0x7FFFFFFF, ignored = 0;
+            if ((x & 0x7F800000) == 0)
+            {
+                spu.fpscr.w(3) |= 0x800 >> i;
+                t.w(i) = 0x7FFFFFFF;
+            }
+            else
+                t.w(i) = sp_estimate(1.0 / sqrt(sp_value(x, ignored)));
+        }
+        return CONTINUE;
+    }
+    static int fi(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.gpr[f_rb(op)];
+        return CONTINUE;
+    }
+
+    // Conversions, the scale is encoded as 173 - scale (float to int) or
+    // 155 - scale (int to float)
+    static int cflts(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        int scale = 173 - (int)f_i8(op);
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 ignored = 0;
+            double v = ldexp(sp_value(xa.w(i), ignored), scale);
+            t.w(i) = v >= 2147483648.0 ? 0x7FFFFFFF : v < -2147483648.0 ? 0x80000000 : (u32)(s32)v;
+        }
+        return CONTINUE;
+    }
+    static int cfltu(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        int scale = 173 - (int)f_i8(op);
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 ignored = 0;
+            double v = ldexp(sp_value(xa.w(i), ignored), scale);
+            t.w(i) = v >= 4294967296.0 ? 0xFFFFFFFF : v < 1.0 ? 0 : (u32)v;
+        }
+        return CONTINUE;
+    }
+    // Denormal results still raise UNF+DIFF, see the csflt tests
+    static int csflt(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        int scale = 155 - (int)f_i8(op);
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 flags = 0;
+            t.w(i) = sp_result(ldexp((double)(s32)xa.w(i), -scale), flags);
+            spu.fpscr.w(i) |= flags;
+        }
+        return CONTINUE;
+    }
+    static int cuflt(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        int scale = 155 - (int)f_i8(op);
+        for (int i = 0; i < 4; ++i)
+        {
+            u32 flags = 0;
+            t.w(i) = sp_result(ldexp((double)xa.w(i), -scale), flags);
+            spu.fpscr.w(i) |= flags;
+        }
+        return CONTINUE;
+    }
+
+    // Double precision arithmetic
+#define DP_OP(name, kind, useRt) \
+    static int name(Spu &spu, u32 op) \
+    { \
+        const v128 xa = spu.gpr[f_ra(op)], xb = spu.gpr[f_rb(op)]; \
+        v128 &t = spu.gpr[f_rt(op)]; \
+        for (int i = 0; i < 2; ++i) \
+        { \
+            u32 flags = 0; \
+            t.d(i) = dp_arith(kind, xa.d(i), xb.d(i), useRt ? t.d(i) : 0, dp_mode(spu, i), flags); \
+            spu.fpscr.w(1 + i) |= flags; \
+        } \
+        return CONTINUE; \
+    }
+
+    DP_OP(dfa, DF_ADD, false)
+    DP_OP(dfs, DF_SUB, false)
+    DP_OP(dfm, DF_MUL, false)
+    DP_OP(dfma, DF_MA, true)
+    DP_OP(dfms, DF_MS, true)
+    DP_OP(dfnms, DF_NMS, true)
+    DP_OP(dfnma, DF_NMA, true)
+
+    // Single (words 0 and 2) to double and back, both IEEE
+    static int fesd(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 2; ++i)
+        {
+            u32 x = xa.w(i * 2), flags = 0;
+            u64 r;
+            if ((x & 0x7FFFFFFF) > 0x7F800000)
+            {
+                flags |= FPSCR_DNAN | ((x & 0x00400000) ? 0 : FPSCR_DINV);
+                r = DP_DEFAULT_NAN;
+            }
+            else if ((x & 0x7F800000) == 0 && (x & 0x7FFFFF))
+            {
+                flags |= FPSCR_DDENORM;
+                r = (u64)(x & 0x80000000) << 32;
+            }
+            else
+            {
+                float f;
+                memcpy(&f, &x, sizeof(f));
+                r = dp_bits((double)f);
+            }
+            t.d(i) = r;
+            spu.fpscr.w(1 + i) |= flags;
+        }
+        return CONTINUE;
+    }
+    static int frds(Spu &spu, u32 op)
+    {
+        const v128 xa = spu.gpr[f_ra(op)];
+        v128 &t = spu.gpr[f_rt(op)];
+        for (int i = 0; i < 2; ++i)
+        {
+            u64 x = xa.d(i);
+            u32 flags = 0, r;
+            if (dp_is_nan(x))
+            {
+                flags |= FPSCR_DNAN | (dp_is_snan(x) ? FPSCR_DINV : 0);
+                r = 0x7FC00000;
+            }
+            else
+            {
+                double d = dp_value(x, flags);
+                fesetround(dpRounding[dp_mode(spu, i)]);
+                feclearexcept(FE_ALL_EXCEPT);
+                volatile float f = (float)d;
+                flags |= host_flags_to_dp();
+                fesetround(FE_TOWARDZERO);
+                float fr = f;
+                memcpy(&r, &fr, sizeof(r));
+            }
+            t.w(i * 2) = r;
+            t.w(i * 2 + 1) = 0;
+            spu.fpscr.w(1 + i) |= flags;
+        }
+        return CONTINUE;
+    }
+
+    static int fscrrd(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = spu.fpscr;
+        return CONTINUE;
+    }
+    static int fscrwr(Spu &spu, u32 op)
+    {
+        const v128 a = spu.gpr[f_ra(op)];
+        spu.fpscr = v128::from_words(a.w(0) & 0xF07, a.w(1) & 0x3F07, a.w(2) & 0x3F07, a.w(3) & 0xF07);
+        return CONTINUE;
+    }
+
+    //----------------------------------------------------------------------
+    // Control, SPRs and channels
+    //----------------------------------------------------------------------
+    static int stop(Spu &spu, u32 op)
+    {
+        spu.stopCode = op & 0x3FFF;
+        return Spu::RUN_STOP;
+    }
+    static int stopd(Spu &spu, u32 op)
+    {
+        (void)op;
+        spu.stopCode = 0x3FFF;
+        return Spu::RUN_STOP;
+    }
+
+    // There are no SPRs on the Cell SPU, reads give zero and writes are dropped
+    static int mfspr(Spu &spu, u32 op)
+    {
+        spu.gpr[f_rt(op)] = v128::from_words(0, 0, 0, 0);
+        return CONTINUE;
+    }
+    static int mtspr(Spu &spu, u32 op) { (void)spu; (void)op; return CONTINUE; }
+
+    static int blocked(Spu &spu)
+    {
+        spu.npc = spu.pc;
+        return Spu::RUN_CHANNEL_BLOCKED;
+    }
+
+    static int rdch(Spu &spu, u32 op)
+    {
+        u32 value;
+        switch (f_ra(op))
+        {
+        case SPU_RdEventStat:
+            if ((spu.eventStat & spu.eventMask) == 0)
+                return blocked(spu);
+            value = spu.eventStat & spu.eventMask;
+            break;
+        case SPU_RdSigNotify1:
+        case SPU_RdSigNotify2:
+        {
+            int n = f_ra(op) - SPU_RdSigNotify1;
+            if (!spu.snrValid[n])
+                return blocked(spu);
+            value = spu.snr[n];
+            spu.snr[n] = 0;
+            spu.snrValid[n] = false;
+            break;
+        }
+        case SPU_RdDec: value = spu.decValue - (u32)(spu.instructionCount - spu.decStart); break;
+        case SPU_RdEventMask: value = spu.eventMask; break;
+        case SPU_RdMachStat: value = 0; break;
+        case SPU_RdSRR0: value = spu.srr0; break;
+        case MFC_RdTagStat: value = spu.tagMask; break;  // DMA completes immediately
+        case SPU_RdInMbox:
+            if (spu.inMbox.empty())
+                return blocked(spu);
+            value = spu.inMbox.front();
+            spu.inMbox.pop_front();
+            break;
+        case MFC_RdListStallStat:
+        case MFC_RdAtomicStat:
+            return blocked(spu);
+        default:
+            return Spu::RUN_INVALID_CHANNEL;
+        }
+        spu.gpr[f_rt(op)] = v128::from_words(value, 0, 0, 0);
+        return CONTINUE;
+    }
+
+    static int wrch(Spu &spu, u32 op)
+    {
+        u32 value = spu.gpr[f_rt(op)].w(0);
+        switch (f_ra(op))
+        {
+        case SPU_WrEventMask: spu.eventMask = value; break;
+        case SPU_WrEventAck: spu.eventStat &= ~value; break;
+        case SPU_WrDec:
+            spu.decValue = value;
+            spu.decStart = spu.instructionCount;
+            break;
+        case SPU_WrSRR0: spu.srr0 = value & (Spu::LS_SIZE - 1) & ~3; break;
+        case MFC_LSA:
+        case MFC_EAH:
+        case MFC_EAL:
+        case MFC_Size:
+        case MFC_TagID:
+        case MFC_Cmd:  // no main memory on the host, commands are recorded only
+            spu.mfcRegs[f_ra(op) - MFC_LSA] = value;
+            break;
+        case MFC_WrTagMask: spu.tagMask = value; break;
+        case MFC_WrTagUpdate:
+        case MFC_WrListStallAck:
+            break;
+        case SPU_WrOutMbox:
+            if (!spu.outMbox.empty())
+                return blocked(spu);
+            spu.outMbox.push_back(value);
+            break;
+        case SPU_WrOutIntrMbox:
+            if (!spu.outIntrMbox.empty())
+                return blocked(spu);
+            spu.outIntrMbox.push_back(value);
+            break;
+        default:
+            return Spu::RUN_INVALID_CHANNEL;
+        }
+        return CONTINUE;
+    }
+
+    static int rchcnt(Spu &spu, u32 op)
+    {
+        u32 count;
+        switch (f_ra(op))
+        {
+        case SPU_RdEventStat: count = (spu.eventStat & spu.eventMask) ? 1 : 0; break;
+        case SPU_RdSigNotify1: count = spu.snrValid[0]; break;
+        case SPU_RdSigNotify2: count = spu.snrValid[1]; break;
+        case SPU_WrEventMask:
+        case SPU_WrEventAck:
+        case SPU_WrDec:
+        case SPU_RdDec:
+        case SPU_RdEventMask:
+        case SPU_RdMachStat:
+        case SPU_WrSRR0:
+        case SPU_RdSRR0:
+        case MFC_LSA:
+        case MFC_EAH:
+        case MFC_EAL:
+        case MFC_Size:
+        case MFC_TagID:
+        case MFC_WrTagMask:
+        case MFC_WrTagUpdate:
+        case MFC_RdTagStat:
+        case MFC_WrListStallAck:
+            count = 1;
+            break;
+        case MFC_Cmd: count = 16; break;
+        case SPU_WrOutMbox: count = spu.outMbox.empty() ? 1 : 0; break;
+        case SPU_WrOutIntrMbox: count = spu.outIntrMbox.empty() ? 1 : 0; break;
+        case SPU_RdInMbox: count = spu.inMbox.size() > 4 ? 4 : (u32)spu.inMbox.size(); break;
+        default: count = 0; break;
+        }
+        spu.gpr[f_rt(op)] = v128::from_words(count, 0, 0, 0);
+        return CONTINUE;
+    }
+
+    static int invalid(Spu &spu, u32 op) { (void)spu; (void)op; return Spu::RUN_INVALID_INSTRUCTION; }
+};
+
+//--------------------------------------------------------------------------
+// Decoding
+//--------------------------------------------------------------------------
+SpuInterpreter::Handler SpuInterpreter::decodeTable[2048];
+
+void SpuInterpreter::build_decode_table()
+{
+    static bool built = false;
+    if (built)
+        return;
+    built = true;
+
+    struct Entry
+    {
+        u32 opcode;
+        int bits;
+        Handler handler;
+    };
+    static const Entry entries[] =
+    {
+        // RRR
+        { 0x8, 4, SpuOps::selb }, { 0xB, 4, SpuOps::shufb }, { 0xC, 4, SpuOps::mpya },
+        { 0xD, 4, SpuOps::fnms }, { 0xE, 4, SpuOps::fma_ }, { 0xF, 4, SpuOps::fms },
+        // RI18
+        { 0x08, 7, SpuOps::nop }, { 0x09, 7, SpuOps::nop }, { 0x21, 7, SpuOps::ila },  // hbra, hbrr
+        // RI10
+        { 0x04, 8, SpuOps::ori }, { 0x05, 8, SpuOps::orhi }, { 0x06, 8, SpuOps::orbi },
+        { 0x0C, 8, SpuOps::sfi }, { 0x0D, 8, SpuOps::sfhi },
+        { 0x14, 8, SpuOps::andi }, { 0x15, 8, SpuOps::andhi }, { 0x16, 8, SpuOps::andbi },
+        { 0x1C, 8, SpuOps::ai }, { 0x1D, 8, SpuOps::ahi },
+        { 0x24, 8, SpuOps::stqd }, { 0x34, 8, SpuOps::lqd },
+        { 0x44, 8, SpuOps::xori }, { 0x45, 8, SpuOps::xorhi }, { 0x46, 8, SpuOps::xorbi },
+        { 0x4C, 8, SpuOps::cgti }, { 0x4D, 8, SpuOps::cgthi }, { 0x4E, 8, SpuOps::cgtbi }, { 0x4F, 8, SpuOps::hgti },
+        { 0x5C, 8, SpuOps::clgti }, { 0x5D, 8, SpuOps::clgthi }, { 0x5E, 8, SpuOps::clgtbi }, { 0x5F, 8, SpuOps::hlgti },
+        { 0x74, 8, SpuOps::mpyi }, { 0x75, 8, SpuOps::mpyui },
+        { 0x7C, 8, SpuOps::ceqi }, { 0x7D, 8, SpuOps::ceqhi }, { 0x7E, 8, SpuOps::ceqbi }, { 0x7F, 8, SpuOps::heqi },
+        // RI16
+        { 0x040, 9, SpuOps::brz }, { 0x041, 9, SpuOps::stqa }, { 0x042, 9, SpuOps::brnz },
+        { 0x044, 9, SpuOps::brhz }, { 0x046, 9, SpuOps::brhnz }, { 0x047, 9, SpuOps::stqr },
+        { 0x060, 9, SpuOps::bra }, { 0x061, 9, SpuOps::lqa }, { 0x062, 9, SpuOps::brasl },
+        { 0x064, 9, SpuOps::br }, { 0x065, 9, SpuOps::fsmbi }, { 0x066, 9, SpuOps::brsl }, { 0x067, 9, SpuOps::lqr },
+        { 0x081, 9, SpuOps::il }, { 0x082, 9, SpuOps::ilhu }, { 0x083, 9, SpuOps::ilh }, { 0x0C1, 9, SpuOps::iohl },
+        // RI8
+        { 0x1D8, 10, SpuOps::cflts }, { 0x1D9, 10, SpuOps::cfltu }, { 0x1DA, 10, SpuOps::csflt }, { 0x1DB, 10, SpuOps::cuflt },
+        // RR / RI7
+        { 0x000, 11, SpuOps::stop }, { 0x001, 11, SpuOps::nop }, { 0x002, 11, SpuOps::nop }, { 0x003, 11, SpuOps::nop },
+        { 0x00C, 11, SpuOps::mfspr }, { 0x00D, 11, SpuOps::rdch }, { 0x00F, 11, SpuOps::rchcnt },
+        { 0x040, 11, SpuOps::sf }, { 0x041, 11, SpuOps::or_ }, { 0x042, 11, SpuOps::bg },
+        { 0x048, 11, SpuOps::sfh }, { 0x049, 11, SpuOps::nor }, { 0x053, 11, SpuOps::absdb },
+        { 0x058, 11, SpuOps::rot }, { 0x059, 11, SpuOps::rotm }, { 0x05A, 11, SpuOps::rotma }, { 0x05B, 11, SpuOps::shl },
+        { 0x05C, 11, SpuOps::roth }, { 0x05D, 11, SpuOps::rothm }, { 0x05E, 11, SpuOps::rotmah }, { 0x05F, 11, SpuOps::shlh },
+        { 0x078, 11, SpuOps::roti }, { 0x079, 11, SpuOps::rotmi }, { 0x07A, 11, SpuOps::rotmai }, { 0x07B, 11, SpuOps::shli },
+        { 0x07C, 11, SpuOps::rothi }, { 0x07D, 11, SpuOps::rothmi }, { 0x07E, 11, SpuOps::rotmahi }, { 0x07F, 11, SpuOps::shlhi },
+        { 0x0C0, 11, SpuOps::a }, { 0x0C1, 11, SpuOps::and_ }, { 0x0C2, 11, SpuOps::cg },
+        { 0x0C8, 11, SpuOps::ah }, { 0x0C9, 11, SpuOps::nand }, { 0x0D3, 11, SpuOps::avgb },
+        { 0x10C, 11, SpuOps::mtspr }, { 0x10D, 11, SpuOps::wrch },
+        { 0x128, 11, SpuOps::biz }, { 0x129, 11, SpuOps::binz }, { 0x12A, 11, SpuOps::bihz }, { 0x12B, 11, SpuOps::bihnz },
+        { 0x140, 11, SpuOps::stopd }, { 0x144, 11, SpuOps::stqx },
+        { 0x1A8, 11, SpuOps::bi }, { 0x1A9, 11, SpuOps::bisl }, { 0x1AA, 11, SpuOps::iret }, { 0x1AB, 11, SpuOps::bisled },
+        { 0x1AC, 11, SpuOps::nop },  // hbr
+        { 0x1B0, 11, SpuOps::gb }, { 0x1B1, 11, SpuOps::gbh }, { 0x1B2, 11, SpuOps::gbb },
+        { 0x1B4, 11, SpuOps::fsm }, { 0x1B5, 11, SpuOps::fsmh }, { 0x1B6, 11, SpuOps::fsmb },
+        { 0x1B8, 11, SpuOps::frest }, { 0x1B9, 11, SpuOps::frsqest },
+        { 0x1C4, 11, SpuOps::lqx },
+        { 0x1CC, 11, SpuOps::rotqbybi }, { 0x1CD, 11, SpuOps::rotqmbybi }, { 0x1CF, 11, SpuOps::shlqbybi },
+        { 0x1D4, 11, SpuOps::cbx }, { 0x1D5, 11, SpuOps::chx }, { 0x1D6, 11, SpuOps::cwx }, { 0x1D7, 11, SpuOps::cdx },
+        { 0x1D8, 11, SpuOps::rotqbi }, { 0x1D9, 11, SpuOps::rotqmbi }, { 0x1DB, 11, SpuOps::shlqbi },
+        { 0x1DC, 11, SpuOps::rotqby }, { 0x1DD, 11, SpuOps::rotqmby }, { 0x1DF, 11, SpuOps::shlqby },
+        { 0x1F0, 11, SpuOps::orx },
+        { 0x1F4, 11, SpuOps::cbd }, { 0x1F5, 11, SpuOps::chd }, { 0x1F6, 11, SpuOps::cwd }, { 0x1F7, 11, SpuOps::cdd },
+        { 0x1F8, 11, SpuOps::rotqbii }, { 0x1F9, 11, SpuOps::rotqmbii }, { 0x1FB, 11, SpuOps::shlqbii },
+        { 0x1FC, 11, SpuOps::rotqbyi }, { 0x1FD, 11, SpuOps::rotqmbyi }, { 0x1FF, 11, SpuOps::shlqbyi },
+        { 0x201, 11, SpuOps::nop },
+        { 0x240, 11, SpuOps::cgt }, { 0x241, 11, SpuOps::xor_ }, { 0x248, 11, SpuOps::cgth }, { 0x249, 11, SpuOps::eqv },
+        { 0x250, 11, SpuOps::cgtb }, { 0x253, 11, SpuOps::sumb }, { 0x258, 11, SpuOps::hgt },
+        { 0x2A5, 11, SpuOps::clz }, { 0x2A6, 11, SpuOps::xswd }, { 0x2AE, 11, SpuOps::xshw },
+        { 0x2B4, 11, SpuOps::cntb }, { 0x2B6, 11, SpuOps::xsbh },
+        { 0x2C0, 11, SpuOps::clgt }, { 0x2C1, 11, SpuOps::andc }, { 0x2C2, 11, SpuOps::fcgt },
+        { 0x2C4, 11, SpuOps::fa }, { 0x2C5, 11, SpuOps::fs }, { 0x2C6, 11, SpuOps::fm },
+        { 0x2C8, 11, SpuOps::clgth }, { 0x2C9, 11, SpuOps::orc }, { 0x2CA, 11, SpuOps::fcmgt },
+        { 0x2CC, 11, SpuOps::dfa }, { 0x2CD, 11, SpuOps::dfs }, { 0x2CE, 11, SpuOps::dfm },
+        { 0x2D0, 11, SpuOps::clgtb }, { 0x2D8, 11, SpuOps::hlgt },
+        { 0x340, 11, SpuOps::addx }, { 0x341, 11, SpuOps::sfx }, { 0x342, 11, SpuOps::cgx }, { 0x343, 11, SpuOps::bgx },
+        { 0x346, 11, SpuOps::mpyhha }, { 0x34E, 11, SpuOps::mpyhhau },
+        { 0x35C, 11, SpuOps::dfma }, { 0x35D, 11, SpuOps::dfms }, { 0x35E, 11, SpuOps::dfnms }, { 0x35F, 11, SpuOps::dfnma },
+        { 0x398, 11, SpuOps::fscrrd }, { 0x3B8, 11, SpuOps::fesd }, { 0x3B9, 11, SpuOps::frds }, { 0x3BA, 11, SpuOps::fscrwr },
+        { 0x3C0, 11, SpuOps::ceq }, { 0x3C2, 11, SpuOps::fceq },
+        { 0x3C4, 11, SpuOps::mpy }, { 0x3C5, 11, SpuOps::mpyh }, { 0x3C6, 11, SpuOps::mpyhh }, { 0x3C7, 11, SpuOps::mpys },
+        { 0x3C8, 11, SpuOps::ceqh }, { 0x3CA, 11, SpuOps::fcmeq }, { 0x3CC, 11, SpuOps::mpyu }, { 0x3CE, 11, SpuOps::mpyhhu },
+        { 0x3D0, 11, SpuOps::ceqb }, { 0x3D4, 11, SpuOps::fi }, { 0x3D8, 11, SpuOps::heq },
+        // dfceq, dfcmeq, dfcgt, dfcmgt and dftsv are documented but don't
+        // exist on the Cell, they decode as invalid like on hardware
+    };
+
+    for (int i = 0; i < 2048; ++i)
+        decodeTable[i] = SpuOps::invalid;
+    for (size_t e = 0; e < sizeof(entries) / sizeof(entries[0]); ++e)
+    {
+        u32 shift = 11 - entries[e].bits;
+        u32 first = entries[e].opcode << shift;
+        for (u32 i = 0; i < (1u << shift); ++i)
+            decodeTable[first + i] = entries[e].handler;
+    }
+}
+
+//--------------------------------------------------------------------------
+// SpuInterpreter
+//--------------------------------------------------------------------------
+SpuInterpreter::SpuInterpreter()
+{
+    build_decode_table();
+    ls = (u8 *)calloc(LS_SIZE, 1);
+    pc = 0;
+    reset();
+}
+
+SpuInterpreter::~SpuInterpreter()
+{
+    free(ls);
+}
+
+void SpuInterpreter::reset()
+{
+    memset(gpr, 0, sizeof(gpr));
+    memset(&fpscr, 0, sizeof(fpscr));
+    stopCode = 0;
+    instructionCount = 0;
+    inMbox.clear();
+    outMbox.clear();
+    outIntrMbox.clear();
+    snr[0] = snr[1] = 0;
+    snrValid[0] = snrValid[1] = false;
+    eventMask = 0;
+    eventStat = 0;
+    srr0 = 0;
+    memset(mfcRegs, 0, sizeof(mfcRegs));
+    tagMask = 0;
+    npc = 0;
+    decValue = 0;
+    decStart = 0;
+}
+
+u32 SpuInterpreter::read_ls32(u32 addr) const
+{
+    u32 x;
+    memcpy(&x, ls + (addr & (LS_SIZE - 1) & ~3), sizeof(x));
+    return bswap32(x);
+}
+
+void SpuInterpreter::write_ls32(u32 addr, u32 value)
+{
+    value = bswap32(value);
+    memcpy(ls + (addr & (LS_SIZE - 1) & ~3), &value, sizeof(value));
+}
+
+v128 SpuInterpreter::read_ls128(u32 addr) const
+{
+    const u8 *p = ls + (addr & (LS_SIZE - 1) & ~0xF);
+    u64 hi, lo;
+    memcpy(&hi, p, 8);
+    memcpy(&lo, p + 8, 8);
+    v128 r;
+    r._u64[1] = bswap64(hi);
+    r._u64[0] = bswap64(lo);
+    return r;
+}
+
+void SpuInterpreter::write_ls128(u32 addr, const v128 &value)
+{
+    u8 *p = ls + (addr & (LS_SIZE - 1) & ~0xF);
+    u64 hi = bswap64(value._u64[1]), lo = bswap64(value._u64[0]);
+    memcpy(p, &hi, 8);
+    memcpy(p + 8, &lo, 8);
+}
+
+SpuInterpreter::RunResult SpuInterpreter::run(u64 maxInsns)
+{
+    int oldRounding = fegetround();
+    fesetround(FE_TOWARDZERO);
+
+    u64 end = maxInsns ? instructionCount + maxInsns : ~0ULL;
+    int result = CONTINUE;
+    while (result == CONTINUE)
+    {
+        if (instructionCount == end)
+        {
+            result = RUN_LIMIT;
+            break;
+        }
+        u32 insn = read_ls32(pc);
+        npc = (pc + 4) & (LS_SIZE - 1);
+        result = decodeTable[insn >> 21](*this, insn);
+        if (result == RUN_INVALID_INSTRUCTION)
+            break;  // leave pc on the bad instruction
+        pc = npc;
+        instructionCount++;
+    }
+
+    fesetround(oldRounding);
+    return (RunResult)result;
+}
+
+SpuInterpreter::RunResult SpuInterpreter::execute(u32 insn)
+{
+    int oldRounding = fegetround();
+    fesetround(FE_TOWARDZERO);
+
+    npc = (pc + 4) & (LS_SIZE - 1);
+    int result = decodeTable[insn >> 21](*this, insn);
+    if (result != RUN_INVALID_INSTRUCTION)
+    {
+        pc = npc;
+        instructionCount++;
+    }
+
+    fesetround(oldRounding);
+    return result == CONTINUE ? RUN_OK : (RunResult)result;
+}
+
+const char *SpuInterpreter::result_name(RunResult r) const
+{
+    switch (r)
+    {
+    case RUN_OK: return "ok";
+    case RUN_STOP: return "stop";
+    case RUN_HALT: return "halt";
+    case RUN_INVALID_INSTRUCTION: return "invalid instruction";
+    case RUN_INVALID_CHANNEL: return "invalid channel";
+    case RUN_CHANNEL_BLOCKED: return "channel blocked";
+    case RUN_LIMIT: return "instruction limit";
+    }
+    return "?";
+}
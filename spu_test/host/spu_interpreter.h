@@ -0,0 +1,164 @@
+// spu_interpreter.h : host side reference interpreter for the Cell SPU.
+//
+// Models one SPU with its 256KB local store, register file, FPSCR and a
+// minimal channel interface, enough to run cell-spu.s (and other code that
+// stays in local store) without a PS3. Behaviour follows what cell-spu.s
+// checks for on real hardware: truncating extended-range single precision,
+// IEEE double precision with the SPU exception flags, SPRs reading as zero.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+
+typedef uint64_t u64;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t u8;
+typedef int64_t s64;
+typedef int32_t s32;
+typedef int16_t s16;
+typedef int8_t s8;
+
+// 128 bit register, stored in host order so word/halfword math is native.
+// The accessors take SPU (big endian) slot numbers, slot 0 is the preferred
+// slot.
+union v128
+{
+    u8 _u8[16];
+    u16 _u16[8];
+    u32 _u32[4];
+    u64 _u64[2];
+
+    u8 &b(int i) { return _u8[15 - i]; }
+    u16 &h(int i) { return _u16[7 - i]; }
+    u32 &w(int i) { return _u32[3 - i]; }
+    u64 &d(int i) { return _u64[1 - i]; }
+    u8 b(int i) const { return _u8[15 - i]; }
+    u16 h(int i) const { return _u16[7 - i]; }
+    u32 w(int i) const { return _u32[3 - i]; }
+    u64 d(int i) const { return _u64[1 - i]; }
+
+    static v128 from_words(u32 w0, u32 w1, u32 w2, u32 w3)
+    {
+        v128 r;
+        r.w(0) = w0; r.w(1) = w1; r.w(2) = w2; r.w(3) = w3;
+        return r;
+    }
+};
+
+// FPSCR bits, word 0 holds the double precision rounding modes, words 1 and
+// 2 the double precision flags of slot 0 and 1, word 3 divide by zero
+const u32 FPSCR_SDIFF = 1 << 0;
+const u32 FPSCR_SUNF = 1 << 1;
+const u32 FPSCR_SOVF = 1 << 2;
+const u32 FPSCR_DDENORM = 1 << 8;
+const u32 FPSCR_DNAN = 1 << 9;
+const u32 FPSCR_DINV = 1 << 10;
+const u32 FPSCR_DINX = 1 << 11;
+const u32 FPSCR_DUNF = 1 << 12;
+const u32 FPSCR_DOVF = 1 << 13;
+
+// Channel numbers the interpreter knows about
+enum
+{
+    SPU_RdEventStat = 0,
+    SPU_WrEventMask = 1,
+    SPU_WrEventAck = 2,
+    SPU_RdSigNotify1 = 3,
+    SPU_RdSigNotify2 = 4,
+    SPU_WrDec = 7,
+    SPU_RdDec = 8,
+    SPU_RdEventMask = 11,
+    SPU_RdMachStat = 13,
+    SPU_WrSRR0 = 14,
+    SPU_RdSRR0 = 15,
+    MFC_LSA = 16,
+    MFC_EAH = 17,
+    MFC_EAL = 18,
+    MFC_Size = 19,
+    MFC_TagID = 20,
+    MFC_Cmd = 21,
+    MFC_WrTagMask = 22,
+    MFC_WrTagUpdate = 23,
+    MFC_RdTagStat = 24,
+    MFC_RdListStallStat = 25,
+    MFC_WrListStallAck = 26,
+    MFC_RdAtomicStat = 27,
+    SPU_WrOutMbox = 28,
+    SPU_RdInMbox = 29,
+    SPU_WrOutIntrMbox = 30,
+};
+
+class SpuInterpreter
+{
+public:
+    static const u32 LS_SIZE = 0x40000;
+
+    // Why run() returned. After anything but RUN_LIMIT the pc points at the
+    // next instruction, except RUN_CHANNEL_BLOCKED which leaves it on the
+    // channel instruction so it is retried once the host fed the channel.
+    enum RunResult
+    {
+        RUN_OK,                  // execute() only, instruction completed
+        RUN_STOP,                // stop/stopd, code in stopCode
+        RUN_HALT,                // conditional halt taken
+        RUN_INVALID_INSTRUCTION, // unknown or unimplemented opcode
+        RUN_INVALID_CHANNEL,     // rdch/wrch on a channel that doesn't allow it
+        RUN_CHANNEL_BLOCKED,     // read of an empty channel / write of a full one
+        RUN_LIMIT,               // instruction budget used up
+    };
+
+    u8 *ls;
+    v128 gpr[128];
+    v128 fpscr;
+    u32 pc;
+
+    u32 stopCode;
+    u64 instructionCount;
+
+    // Channel state, the host fills/drains these between runs
+    std::deque<u32> inMbox;
+    std::deque<u32> outMbox;
+    std::deque<u32> outIntrMbox;
+    u32 snr[2];
+    bool snrValid[2];
+    u32 eventMask;
+    u32 eventStat;
+    u32 srr0;
+    u32 mfcRegs[6];        // lsa, eah, eal, size, tag, last command
+    u32 tagMask;
+
+    SpuInterpreter();
+    ~SpuInterpreter();
+
+    // Clears registers, FPSCR and channels, local store is left alone
+    void reset();
+
+    // Runs from pc until something needs the host's attention, or maxInsns
+    // instructions have run (0 = no limit)
+    RunResult run(u64 maxInsns = 0);
+
+    // Executes one instruction word as if it were at pc, without it having
+    // to be in local store
+    RunResult execute(u32 insn);
+
+    u32 read_ls32(u32 addr) const;
+    void write_ls32(u32 addr, u32 value);
+    v128 read_ls128(u32 addr) const;
+    void write_ls128(u32 addr, const v128 &value);
+
+    const char *result_name(RunResult r) const;
+
+private:
+    u32 npc;
+    u32 decValue;
+    u64 decStart;
+
+    typedef int (*Handler)(SpuInterpreter &, u32);
+    static Handler decodeTable[2048];
+    static void build_decode_table();
+
+    friend struct SpuOps;
+};
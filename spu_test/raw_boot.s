@@ -0,0 +1,38 @@
+# Bare entry point for running cell-spu.s on a raw SPU, see raw_runner.ppu.c.
+# Uses the same LS layout as host/spu_host_runner.cpp, and places `test` at
+# 0x1000 so the TEST_ABSOLUTE build works. Link with -Ttext=0.
+#
+# Stop codes seen by the runner:
+#    0x3000: test returned, R3 stored at RESULT_ADDR
+#    0x3001, 0x3002: stop round trip timing loop, resume to get the next
+#    one. They alternate so the runner can tell a new stop from a stale one
+# Any other stop, halt or invalid channel is from the test itself and
+# resumed the way cell-spu.s asks for.
+
+STACK_TOP = 0x3FFF0
+FAILURES_ADDR = 0x2C000    # 64KB
+SCRATCH_ADDR = 0x2A000     # 8KB, cleared by the runner
+RESULT_ADDR = 0x29FF0
+
+.text
+.global _start
+_start:
+   ila $1,STACK_TOP
+   il $3,0
+   ila $4,SCRATCH_ADDR
+   ila $5,FAILURES_ADDR
+   lqr $6,r6_init
+   brsl $0,test
+   ila $7,RESULT_ADDR
+   stqd $3,0($7)
+   stop 0x3000
+0: stop 0x3001
+   stop 0x3002
+   br 0b
+
+   .balign 16
+r6_init:
+   .int 0,1,2,4
+
+   .org 0x1000
+.include "cell-spu.s"
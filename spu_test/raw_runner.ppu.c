@@ -0,0 +1,177 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/process.h>
+#include <sys/raw_spu.h>
+#include <sys/spu_image.h>
+#include <sys/spu_initialize.h>
+#include <sys/sys_time.h>
+#include <ppu_intrinsics.h>
+
+SYS_PROCESS_PARAM(1000, 0x10000)
+
+/*
+ * Runs cell-spu.s on a raw SPU through raw_boot.s, so unlike test_runner the
+ * SPU can be resumed after stop, halt and invalid channel events and the
+ * TEST_STOP / TEST_HALT / TEST_ABSOLUTE / TEST_CHANNEL_INVALID builds work
+ */
+
+/* embedded SPU ELF symbols */
+extern char _binary_raw_test_spu_out_start[];
+
+// LS layout and stop codes from raw_boot.s
+#define FAILURES_ADDR 0x2C000
+#define SCRATCH_ADDR 0x2A000
+#define RESULT_ADDR 0x29FF0
+#define STOP_DONE 0x3000
+#define STOP_PING 0x3001
+#define STOP_PONG 0x3002
+
+#define STOP_ROUNDS 10000
+
+// problem state registers
+#define SPU_RUNCNTL_OFFS 0x0401C
+#define SPU_STATUS_OFFS 0x04024
+#define SPU_NPC_OFFS 0x04034
+
+#define SPU_STATUS_RUNNING 0x1
+#define SPU_STATUS_STOPPED_BY_STOP 0x2
+#define SPU_STATUS_STOPPED_BY_HALT 0x4
+#define SPU_STATUS_INVALID_INSTR 0x20
+#define SPU_STATUS_INVALID_CH 0x40
+#define SPU_STOP_STATUS_SHIFT 16
+
+static sys_raw_spu_t spu;
+
+static volatile uint32_t *ls_word(uint32_t addr)
+{
+    return (volatile uint32_t *)(uintptr_t)(RAW_SPU_BASE_ADDR + RAW_SPU_OFFSET * spu + RAW_SPU_LS_OFFSET + addr);
+}
+
+// SPU_Status can still show the previous stop right after the write, so
+// this waits until the SPU is running or SPU_NPC has moved on
+static void spu_run(void)
+{
+    uint32_t npc = sys_raw_spu_mmio_read(spu, SPU_NPC_OFFS);
+    sys_raw_spu_mmio_write(spu, SPU_RUNCNTL_OFFS, 1);
+    while (!(sys_raw_spu_mmio_read(spu, SPU_STATUS_OFFS) & SPU_STATUS_RUNNING) &&
+           sys_raw_spu_mmio_read(spu, SPU_NPC_OFFS) == npc)
+        ;
+}
+
+// Spins until the SPU isn't running any more, returns SPU_Status
+static uint32_t spu_wait(void)
+{
+    uint32_t status;
+    while ((status = sys_raw_spu_mmio_read(spu, SPU_STATUS_OFFS)) & SPU_STATUS_RUNNING)
+        ;
+    return status;
+}
+
+static void print_vec(const char *name, uint32_t addr)
+{
+    printf("%s: 0x%x 0x%x 0x%x 0x%x\n", name, *ls_word(addr), *ls_word(addr + 4),
+           *ls_word(addr + 8), *ls_word(addr + 12));
+}
+
+int main(void)
+{
+    int ret = sys_spu_initialize(1, 1);
+    if (ret != CELL_OK) {
+        printf("sys_spu_initialize failed: %d\n", ret);
+        return ret;
+    }
+
+    ret = sys_raw_spu_create(&spu, NULL);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_create failed: %d\n", ret);
+        return ret;
+    }
+
+    sys_spu_image_t img;
+    ret = sys_spu_image_import(&img, (void*)_binary_raw_test_spu_out_start, SYS_SPU_IMAGE_DIRECT);
+    if (ret != CELL_OK) {
+        printf("sys_spu_image_import: %d\n", ret);
+        return ret;
+    }
+    ret = sys_raw_spu_image_load(spu, &img);
+    if (ret != CELL_OK) {
+        printf("sys_raw_spu_image_load: %d\n", ret);
+        return ret;
+    }
+
+    // cell-spu.s wants the scratch block cleared
+    for (uint32_t addr = SCRATCH_ADDR; addr < FAILURES_ADDR; addr += 4)
+        *ls_word(addr) = 0;
+
+    printf("Starting and running tests\n");
+
+    // The first scratch word tells the test what happened: the stop code
+    // after a stop, 1 after a halt or invalid channel
+    int stops = 0, halts = 0;
+    uint32_t status;
+    spu_run();
+    for (;;) {
+        status = spu_wait();
+        uint32_t code = status >> SPU_STOP_STATUS_SHIFT;
+        if ((status & SPU_STATUS_STOPPED_BY_STOP) && code == STOP_DONE)
+            break;
+        if (status & (SPU_STATUS_STOPPED_BY_HALT | SPU_STATUS_INVALID_CH)) {
+            *ls_word(SCRATCH_ADDR) = 1;
+            ++halts;
+        }
+        else if (status & SPU_STATUS_STOPPED_BY_STOP) {
+            *ls_word(SCRATCH_ADDR) = code;
+            ++stops;
+        }
+        else {
+            printf("spu stopped unexpectedly, status 0x%08x\n", status);
+            sys_raw_spu_destroy(spu);
+            return -1;
+        }
+        spu_run();
+    }
+
+    int numFailed = (int)*ls_word(RESULT_ADDR);
+    printf("done! (%d stops and %d halts resumed)\n", stops, halts);
+    if (numFailed == 0) {
+        printf("No failed instructions detected\n");
+    }
+    else if (numFailed < 0) {
+        printf("test failed to bootstrap itself.\n");
+        if (numFailed == -256)
+            printf("loaded at 0x%x instead of 0x1000\n", *ls_word(RESULT_ADDR + 4));
+    }
+    else {
+        printf("%d failed instructions.\n", numFailed);
+        for (int i = 0; i < numFailed && i < 1024; ++i) {
+            uint32_t rec = FAILURES_ADDR + i * 64;
+            printf("----------------------------------------------------\n");
+            printf("Failed Inst word: 0x%x. Addr: 0x%x\n", *ls_word(rec), *ls_word(rec + 4));
+            print_vec("Output", rec + 16);
+            print_vec("Expected", rec + 32);
+            print_vec("FPSCR", rec + 48);
+        }
+    }
+
+    // stop round trips: resume, SPU stops again right away. The codes
+    // alternate, so a stale status shows up as the wrong one
+    uint64_t tbFreq = sys_time_get_timebase_frequency();
+    uint64_t start = __mftb();
+    for (int i = 0; i < STOP_ROUNDS; ++i) {
+        spu_run();
+        status = spu_wait();
+        uint32_t expected = (i & 1) ? STOP_PONG : STOP_PING;
+        if (!(status & SPU_STATUS_STOPPED_BY_STOP) || (status >> SPU_STOP_STATUS_SHIFT) != expected) {
+            printf("unexpected status 0x%08x in the stop loop\n", status);
+            break;
+        }
+    }
+    double secs = (double)(__mftb() - start) / (double)tbFreq;
+    printf("stop round trip: %.2f us (%.0f per second)\n", secs * 1e6 / STOP_ROUNDS, STOP_ROUNDS / secs);
+
+    sys_raw_spu_destroy(spu);
+    sys_spu_image_close(&img);
+    return numFailed == 0 ? 0 : 1;
+}
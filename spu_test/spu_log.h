@@ -0,0 +1,28 @@
+/*
+ * Batched SPU logging. Each SPU thread formats its messages in local store
+ * and DMAs them in batches into its own ring buffer in main memory, a PPU
+ * thread drains the rings to stdout. A line costs a vsnprintf on the SPU
+ * instead of a full spu_printf round trip through the PPU.
+ *
+ * spu_log_spu.h is the SPU side, spu_log_ppu.h the PPU side.
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Ring size in bytes, a power of two
+#define SPU_LOG_RING_SIZE 0x10000
+
+// Messages are padded with NULs to a multiple of this so every DMA is
+// aligned, the reader skips the padding
+#define SPU_LOG_ALIGN 16
+
+/*
+ * head and tail count bytes since the start and only ever grow, the SPU
+ * owns head and the PPU owns tail. Each sits in its own cache line
+ */
+typedef struct {
+    uint32_t head __attribute__((aligned(128)));
+    uint32_t tail __attribute__((aligned(128)));
+    char data[SPU_LOG_RING_SIZE] __attribute__((aligned(128)));
+} spu_log_ring_t;
@@ -0,0 +1,101 @@
+/*
+ * PPU side of the batched log, see spu_log.h. spu_log_start() zeroes the
+ * rings and starts a thread that prints them to stdout, spu_log_stop()
+ * prints what is left once the SPU threads are done and joins it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/ppu_thread.h>
+#include <sys/timer.h>
+#include <ppu_intrinsics.h>
+
+#include "spu_log.h"
+
+// How long the drain thread sleeps when every ring is empty
+#define SPU_LOG_POLL_US 100
+
+typedef struct {
+    spu_log_ring_t *rings;
+    int numRings;
+    volatile int stop;
+    sys_ppu_thread_t thread;
+} spu_log_drain_t;
+
+static spu_log_drain_t spu_log_state;
+
+// Prints what is new in r, returns the number of bytes consumed
+static inline uint32_t spu_log_drain(spu_log_ring_t *r)
+{
+    uint32_t tail = r->tail;
+    uint32_t head = *(volatile uint32_t *)&r->head;
+    if (head == tail)
+        return 0;
+    __lwsync();     // data is read after head
+
+    for (uint32_t pos = tail; pos != head;) {
+        uint32_t offset = pos & (SPU_LOG_RING_SIZE - 1);
+        uint32_t n = head - pos < SPU_LOG_RING_SIZE - offset ? head - pos : SPU_LOG_RING_SIZE - offset;
+        const char *p = r->data + offset;
+        // runs of text between the NUL padding
+        for (uint32_t i = 0; i < n;) {
+            uint32_t end = i;
+            while (end < n && p[end] != 0)
+                ++end;
+            if (end > i)
+                fwrite(p + i, 1, end - i, stdout);
+            while (end < n && p[end] == 0)
+                ++end;
+            i = end;
+        }
+        pos += n;
+    }
+
+    __lwsync();     // done reading before the SPU may reuse the space
+    *(volatile uint32_t *)&r->tail = head;
+    return head - tail;
+}
+
+static void spu_log_thread(uint64_t arg)
+{
+    (void)arg;
+    for (;;) {
+        int stop = spu_log_state.stop;
+        uint32_t drained = 0;
+        for (int i = 0; i < spu_log_state.numRings; ++i)
+            drained += spu_log_drain(&spu_log_state.rings[i]);
+        // the last pass after stop picks up the final flushes
+        if (stop)
+            break;
+        if (drained == 0)
+            sys_timer_usleep(SPU_LOG_POLL_US);
+    }
+    fflush(stdout);
+    sys_ppu_thread_exit(0);
+}
+
+static inline int spu_log_start(spu_log_ring_t *rings, int numRings)
+{
+    memset(rings, 0, sizeof(spu_log_ring_t) * numRings);
+    spu_log_state.rings = rings;
+    spu_log_state.numRings = numRings;
+    spu_log_state.stop = 0;
+    __lwsync();
+
+    int ret = sys_ppu_thread_create(&spu_log_state.thread, spu_log_thread, 0, 1000, 0x4000,
+                                    SYS_PPU_THREAD_CREATE_JOINABLE, "spu log");
+    if (ret != CELL_OK)
+        printf("sys_ppu_thread_create (spu log) failed: %d\n", ret);
+    return ret;
+}
+
+// Call after the SPU threads have flushed, i.e. after the group join
+static inline void spu_log_stop(void)
+{
+    uint64_t exitStatus;
+    spu_log_state.stop = 1;
+    sys_ppu_thread_join(spu_log_state.thread, &exitStatus);
+}
@@ -0,0 +1,107 @@
+/*
+ * SPU side of the batched log, see spu_log.h. Messages collect in a local
+ * batch that is written to the ring when it fills up, on spu_log_flush()
+ * and on spu_log_sync(). Flush before the thread exits or stops.
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <spu_intrinsics.h>
+#include <spu_mfcio.h>
+
+#include "spu_log.h"
+
+// DMA tag used by the log, spu_bench keeps 31 for itself
+#define SPU_LOG_TAG 30
+
+#define SPU_LOG_BATCH_SIZE 4096
+// Longer messages are truncated
+#define SPU_LOG_LINE_MAX 256
+
+static uint64_t spu_log_ea;
+static uint32_t spu_log_head;       // bytes written to the ring
+static uint32_t spu_log_tail;       // tail as last read back from the ring
+static uint32_t spu_log_used;       // bytes in the batch
+static char spu_log_batch[SPU_LOG_BATCH_SIZE] __attribute__((aligned(128)));
+static volatile uint32_t spu_log_ctl[4] __attribute__((aligned(16)));
+
+// ringEa is a zeroed spu_log_ring_t the PPU drains
+static inline void spu_log_init(uint64_t ringEa)
+{
+    spu_log_ea = ringEa;
+    spu_log_head = 0;
+    spu_log_tail = 0;
+    spu_log_used = 0;
+}
+
+static inline void spu_log_wait(void)
+{
+    mfc_write_tag_mask(1 << SPU_LOG_TAG);
+    mfc_read_tag_status_all();
+}
+
+static inline uint32_t spu_log_read_tail(void)
+{
+    mfc_get(spu_log_ctl, spu_log_ea + offsetof(spu_log_ring_t, tail), 16, SPU_LOG_TAG, 0, 0);
+    spu_log_wait();
+    return spu_log_ctl[0];
+}
+
+// Writes the batch to the ring, waiting for the PPU if the ring is full
+static inline void spu_log_flush(void)
+{
+    uint32_t size = spu_log_used;
+    if (size == 0)
+        return;
+
+    while (spu_log_head + size - spu_log_tail > SPU_LOG_RING_SIZE)
+        spu_log_tail = spu_log_read_tail();
+
+    uint32_t offset = spu_log_head & (SPU_LOG_RING_SIZE - 1);
+    uint32_t first = SPU_LOG_RING_SIZE - offset < size ? SPU_LOG_RING_SIZE - offset : size;
+    uint64_t data = spu_log_ea + offsetof(spu_log_ring_t, data);
+    mfc_put(spu_log_batch, data + offset, first, SPU_LOG_TAG, 0, 0);
+    if (first < size)
+        mfc_put(spu_log_batch + first, data, size - first, SPU_LOG_TAG, 0, 0);
+
+    // fenced, so the PPU never sees the new head before the data
+    spu_log_head += size;
+    spu_log_ctl[0] = spu_log_head;
+    mfc_putf(spu_log_ctl, spu_log_ea + offsetof(spu_log_ring_t, head), 16, SPU_LOG_TAG, 0, 0);
+    spu_log_wait();
+    spu_log_used = 0;
+}
+
+// Flushes and waits until the PPU has printed everything
+static inline void spu_log_sync(void)
+{
+    spu_log_flush();
+    while (spu_log_tail != spu_log_head)
+        spu_log_tail = spu_log_read_tail();
+}
+
+static inline int spu_log_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline int spu_log_printf(const char *fmt, ...)
+{
+    if (spu_log_used + SPU_LOG_LINE_MAX > SPU_LOG_BATCH_SIZE)
+        spu_log_flush();
+
+    char *p = spu_log_batch + spu_log_used;
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(p, SPU_LOG_LINE_MAX, fmt, ap);
+    va_end(ap);
+    if (len < 0)
+        return len;
+    if (len >= SPU_LOG_LINE_MAX)
+        len = SPU_LOG_LINE_MAX - 1;
+
+    uint32_t padded = (len + SPU_LOG_ALIGN - 1) & ~(SPU_LOG_ALIGN - 1);
+    for (uint32_t i = len; i < padded; ++i)
+        p[i] = 0;
+    spu_log_used += padded;
+    return len;
+}
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <sys/spu_thread_group.h>
 #include <sys/spu_thread.h>
@@ -9,12 +10,15 @@
 #include <sys/spu_image.h>
 #include <sys/spu_initialize.h>
 
-#include <spu_printf.h>
+#include "spu_log_ppu.h"
 
 
 /* embedded SPU ELF symbols */
 extern char _binary_test_spu_spu_out_start[];
 
+// SPU output, drained by a PPU thread
+static spu_log_ring_t logRing __attribute__((aligned(128)));
+
 int main(void)
 {
 	int ret;
@@ -51,23 +55,17 @@ int main(void)
     sys_spu_thread_attribute_initialize(thr_attr);
     sys_spu_thread_attribute_name(thr_attr, "test spu thread");
     sys_spu_thread_argument_t thr_args;
+    memset(&thr_args, 0, sizeof(thr_args));
+    thr_args.arg1 = (uint64_t)(uintptr_t)&logRing;
     ret = sys_spu_thread_initialize(&thr_id, grp_id, 0, &img, &thr_attr, &thr_args);
     if (ret != CELL_OK) {
         printf("sys_spu_thread_initialize: %d\n", ret);
         return ret;
     }
 
-    ret = spu_printf_initialize(1000, NULL);
-    if (ret != CELL_OK) {
-        printf("spu_printf_initialize failed %x\n", ret);
+    ret = spu_log_start(&logRing, 1);
+    if (ret != CELL_OK)
         exit(-1);
-    }
-
-    ret = spu_printf_attach_group(grp_id);
-    if (ret != CELL_OK) {
-        printf("spu_printf_attach_group failed %x\n", ret);
-        exit(-1);
-    }
 
     ret = sys_spu_thread_group_start(grp_id);    
     if (ret != CELL_OK) {
@@ -83,8 +81,7 @@ int main(void)
         return ret;
     }
 
-    spu_printf_detach_group(grp_id);
-    spu_printf_finalize();
+    spu_log_stop();
 
     ret = sys_spu_thread_group_destroy(grp_id);
     if (ret != CELL_OK) {
@@ -1,12 +1,12 @@
 #include <sys/spu_thread.h>	
-#include <spu_printf.h>
 #include <spu_intrinsics.h>
 
+#include "spu_log_spu.h"
+
 extern vec_int4 test(vec_int4 r3, void *scratch, void *failures, vec_int4 r6);
 
 int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
 {
-    (void)arg1;
     (void)arg2;
     (void)arg3;
 	(void)arg4;
@@ -14,17 +14,20 @@ int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
     char scratchBuf[8192] __attribute__((aligned(128))) = {0};
     char failedBuf[65536] = {0};
 
-    spu_printf("Starting and running tests\n");
+    // arg1 is the log ring, the failure dump goes out in batches instead of
+    // one spu_printf round trip per line
+    spu_log_init(arg1);
+    spu_log_printf("Starting and running tests\n");
 
     vec_int4 res = test((vec_int4){0,0,0,0}, &scratchBuf, &failedBuf, (vec_int4){0,1,2,4});
 
     int numFailed = spu_extract(res, 0);
-    spu_printf("done!\n");
+    spu_log_printf("done!\n");
     if (numFailed == 0) {
-        spu_printf("No failed instructions detected\n");
+        spu_log_printf("No failed instructions detected\n");
     }
     else if (numFailed < 0) {
-        spu_printf("test failed to bootstrap itself.\n");
+        spu_log_printf("test failed to bootstrap itself.\n");
     }
     else {
         /* 
@@ -42,24 +45,26 @@ int main(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
         # failing instruction; the address is provided as an additional aid in
         # locating the instruction.*/
 
-        spu_printf("%d failed instructions.\n", numFailed);
+        spu_log_printf("%d failed instructions.\n", numFailed);
 
         vec_int4 *fail = (vec_int4 *)&failedBuf;
         for (int i =0; i < numFailed; ++i) {
-            spu_printf("----------------------------------------------------\n");
-            spu_printf("Failed Inst word: 0x%x. Addr: 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1));
+            spu_log_printf("----------------------------------------------------\n");
+            spu_log_printf("Failed Inst word: 0x%x. Addr: 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1));
             fail += 1;
-            spu_printf("Output: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
+            spu_log_printf("Output: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
             fail += 1;
-            spu_printf("Expected: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
+            spu_log_printf("Expected: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
             fail += 1;
-            spu_printf("FPSCR: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
+            spu_log_printf("FPSCR: 0x%x 0x%x 0x%x 0x%x\n", spu_extract(*fail, 0), spu_extract(*fail, 1), spu_extract(*fail, 2), spu_extract(*fail, 3));
             fail += 1;
         }
 
-        spu_printf("Throwing assert\n");
+        spu_log_printf("Throwing assert\n");
+        spu_log_sync();
         __asm__ volatile ("stopd $2, $2, $2");
     }
+    spu_log_flush();
     sys_spu_thread_exit(0);
 	return 0;
 }
\ No newline at end of file